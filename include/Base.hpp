@@ -1,7 +1,20 @@
 #pragma once
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include "FFT.hpp"
 #include "Filters.hpp"
+#include "LockFree.hpp"
 
 #ifdef _IMPORTEFFECTBASE_
 #define DLLDIR
@@ -24,6 +37,16 @@ namespace SoundMixr
 		union { T y, end, g, height; };
 	};
 
+	/**
+	 * Automation of a parameter at a sample within a block.
+	 */
+	struct AutomationEvent
+	{
+		int offset; // Sample within the block
+		int id;     // Object id of the Parameter
+		float value; // Normalized value
+	};
+
 	/**
 	 * Datatype for a midi link with a parameter.
 	 */
@@ -42,12 +65,155 @@ namespace SoundMixr
 		Knob, Slider, VolumeSlider
 	};
 
+	/**
+	 * Queue of ids of Objects changed on the UI thread, drained by the audio thread.
+	 */
+	using ChangeQueue = SPSCQueue<int, 1024>;
+
+	/**
+	 * Writes binary state to a caller provided buffer. Without a buffer, or once the buffer
+	 * is full, nothing is written but Size() still counts the bytes, so the same code can be
+	 * used to calculate the required size. Values are stored in native byte order.
+	 */
+	class StateWriter
+	{
+	public:
+		StateWriter(uint8_t* data = nullptr, size_t size = 0)
+			: m_Data(data), m_Capacity(size)
+		{}
+
+		/**
+		 * Write a trivially copyable value.
+		 * @param v value
+		 */
+		template<typename T>
+		void Write(const T& v)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (m_Data && m_Size + sizeof(T) <= m_Capacity)
+				std::memcpy(m_Data + m_Size, &v, sizeof(T));
+			m_Size += sizeof(T);
+		}
+
+		/**
+		 * Start a size prefixed record.
+		 * @return position to pass to End
+		 */
+		size_t Begin() { size_t at = m_Size; Write<uint32_t>(0); return at; }
+
+		/**
+		 * End a size prefixed record, fills in the size.
+		 * @param at position returned by Begin
+		 */
+		void End(size_t at)
+		{
+			uint32_t size = static_cast<uint32_t>(m_Size - at - sizeof(uint32_t));
+			if (m_Data && at + sizeof(uint32_t) <= m_Capacity)
+				std::memcpy(m_Data + at, &size, sizeof(uint32_t));
+		}
+
+		/**
+		 * @return amount of bytes written, or that would have been written
+		 */
+		size_t Size() const { return m_Size; }
+
+		/**
+		 * @return true when everything fit in the buffer
+		 */
+		bool Good() const { return m_Data && m_Size <= m_Capacity; }
+
+	private:
+		uint8_t* m_Data;
+		size_t m_Capacity;
+		size_t m_Size = 0;
+	};
+
+	/**
+	 * Reads binary state written by a StateWriter. Reading past the end of the buffer, or of
+	 * the current record, fails and leaves the value untouched, so records written by an older
+	 * version with fewer fields load their defaults for the new fields.
+	 */
+	class StateReader
+	{
+	public:
+		StateReader(const uint8_t* data, size_t size)
+			: m_Data(data), m_Size(size), m_End(size)
+		{}
+
+		/**
+		 * Read a trivially copyable value.
+		 * @param v receives the value
+		 * @return false when there was no data left
+		 */
+		template<typename T>
+		bool Read(T& v)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			if (m_Pos + sizeof(T) > m_End)
+			{
+				// Running out of a record is expected for older versions, out of the buffer isn't
+				if (m_End == m_Size)
+					m_Good = false;
+				return false;
+			}
+
+			std::memcpy(&v, m_Data + m_Pos, sizeof(T));
+			m_Pos += sizeof(T);
+			return true;
+		}
+
+		/**
+		 * Read a value, or return a default when there was no data left.
+		 * @param def default
+		 * @return value
+		 */
+		template<typename T>
+		T Read(const T& def)
+		{
+			T v = def;
+			Read(v);
+			return v;
+		}
+
+		/**
+		 * Start reading a size prefixed record.
+		 * @return position to pass to End
+		 */
+		size_t Begin()
+		{
+			uint32_t size = 0;
+			Read(size);
+			if (m_Pos + size > m_Size)
+				m_Good = false;
+			m_End = std::min(m_Pos + size, m_Size);
+			return m_End;
+		}
+
+		/**
+		 * Skip to the end of a record, whether all of it was read or not.
+		 * @param end position returned by Begin
+		 */
+		void End(size_t end) { m_Pos = end, m_End = m_Size; }
+
+		/**
+		 * @return true when no read failed so far
+		 */
+		bool Good() const { return m_Good; }
+
+	private:
+		const uint8_t* m_Data;
+		size_t m_Size, m_End;
+		size_t m_Pos = 0;
+		bool m_Good = true;
+	};
+
 	/**
 	 * Basis for any Effect related object
 	 */
 	class DLLDIR Object
 	{
 	public:
+		virtual ~Object() {}
 
 		/**
 		 * Set the size.
@@ -81,8 +247,87 @@ namespace SoundMixr
 		virtual operator nlohmann::json() { return nlohmann::json::object(); };
 		virtual void operator=(const nlohmann::json& json) {};
 
+		/**
+		 * Write the state in the compact binary format, the binary
+		 * counterpart of the json operator.
+		 * @param w writer
+		 */
+		virtual void Save(StateWriter& /*w*/) {};
+
+		/**
+		 * Read the state written by Save.
+		 * @param r reader
+		 */
+		virtual void Load(StateReader& /*r*/) {};
+
+		/**
+		 * Get the id of this Object within its plugin.
+		 * @return id, -1 when not added to a plugin
+		 */
+		int ObjectId() const { return m_ObjectId; }
+
+		/**
+		 * Attach this Object to the change queue of a plugin, done by the PluginBase factories.
+		 * @param queue change queue
+		 * @param id id of this Object
+		 * @param clock generation clock of the plugin
+		 * @param resync set when the queue is full, the plugin then resyncs all Objects
+		 */
+		void Attach(ChangeQueue* queue, int id, std::atomic<uint64_t>* clock = nullptr, std::atomic<bool>* resync = nullptr)
+		{
+			m_Changes = queue, m_ObjectId = id, m_Clock = clock, m_Resync = resync;
+		}
+
+		/**
+		 * Get the generation of the last change to the state of this Object, the
+		 * value of the plugin's generation clock right after the change.
+		 * @return generation, 0 when never changed
+		 */
+		uint64_t Generation() const { return m_Generation.load(std::memory_order_acquire); }
+
+		/**
+		 * Allow this Object to be queued again, called by PluginBase::DrainChanges
+		 * before the audio thread reads the new values.
+		 */
+		void Acknowledge() { m_Pending = false; }
+
+	protected:
+
+		/**
+		 * Notify the audio thread of a change, call after setting the new value. Only
+		 * queues the id if it isn't already waiting in the queue. When the queue is
+		 * full the change isn't lost, the plugin resyncs all Objects instead.
+		 */
+		void Changed()
+		{
+			Touched();
+			if (m_Changes && !m_Pending.exchange(true))
+				if (!m_Changes->Push(m_ObjectId))
+				{
+					if (m_Resync)
+						m_Resync->store(true, std::memory_order_release);
+					else
+						m_Pending = false;
+				}
+		}
+
+		/**
+		 * Mark the state as changed for saving, without notifying the audio
+		 * thread. Changed() already does this.
+		 */
+		void Touched()
+		{
+			m_Generation.store(m_Clock ? m_Clock->fetch_add(1) + 1 : m_Generation + 1, std::memory_order_release);
+		}
+
 	private:
 		Pair<int> m_Size{ 30, 30 }, m_Position{ 0, 0 };
+		ChangeQueue* m_Changes = nullptr;
+		std::atomic<bool>* m_Resync = nullptr;
+		std::atomic<bool> m_Pending{ false };
+		std::atomic<uint64_t>* m_Clock = nullptr;
+		std::atomic<uint64_t> m_Generation{ 0 };
+		int m_ObjectId = -1;
 	};
 
 	/**
@@ -300,12 +545,18 @@ namespace SoundMixr
 			Log, Pow
 		};
 
+		enum class Smoothing
+		{
+			Exponential, Linear
+		};
+
 		Pair<double> range{ 0, 100 };       // The range of this Parameter.
 		double multiplier = 1;              // Multiplier for the speed at which the parameter value changes per pixel dragged with the mouse.
 		Scaling scalingType = Scaling::Pow; // Set the scaling type for the value of this Parameter.
 		double scaling = 1;                 // Scaling amount for the value of this Parameter.
 		bool enableSmoothing = false;       // Enable the value smoothing.
-		double smoothingAmount = 1;         // Lerping amount per sample.
+		double smoothingAmount = 1;         // Lerping amount per sample, or normalized step per sample when linear.
+		Smoothing smoothingType = Smoothing::Exponential; // Set the smoothing type for the value of this Parameter.
 		bool vertical = true;               // Is this parameter displayed/dragged vertically?
 		int decimals = 1;                   // The amount of decimals that should be displayed for this Parameter.
 		bool displayValue = true;           // Enable/Disable the displaying of the value.
@@ -317,6 +568,7 @@ namespace SoundMixr
 	 */
 	class Parameter : public Object
 	{
+		friend class PresetMorph;
 	public:
 
 		/**
@@ -326,13 +578,15 @@ namespace SoundMixr
 		 */
 		Parameter(const std::string& name = "", ParameterType t = ParameterType::Knob)
 			: m_Name(name), m_Type(t)
-		{}
+		{
+			UpdateConversion();
+		}
 
 		/**
 		 * Set the parameter settings.
 		 * @param s parameter settings
 		 */
-		virtual void Data(const ParameterData& d) { m_Data = d; }
+		virtual void Data(const ParameterData& d) { m_Data = d; UpdateConversion(); Changed(); }
 		
 		/**
 		 * Get the parameter settings.
@@ -356,7 +610,7 @@ namespace SoundMixr
 		 * Set the range of this Parameter.
 		 * @param r range
 		 */
-		virtual void Range(const Pair<double>& r) { m_Data.range = r; ConstrainValue(); }
+		virtual void Range(const Pair<double>& r) { m_Data.range = r; UpdateConversion(); Changed(); }
 
 		/**
 		 * Get the range of this Parameter.
@@ -368,19 +622,89 @@ namespace SoundMixr
 		 * Set the value of this Parameter.
 		 * @param v value
 		 */
-		virtual void Value(double v) { m_Value = Normalize(v); ConstrainValue(); }
+		virtual void Value(double v) { Store(Normalize(v)); }
 
 		/**
 		 * Get the value of this Parameter.
 		 * @return value
 		 */
-		virtual double Value() { m_Data.enableSmoothing ? m_RValue += m_Data.smoothingAmount * (m_Value - m_RValue) : m_RValue = m_Value; return Convert(m_RValue); }
+		virtual double Value() { m_RValue = Smooth(m_RValue); return Convert(m_RValue); }
+
+		/**
+		 * Fill a buffer with the value of this Parameter for each sample, the same as
+		 * calling Value() once per sample, but smoothing and conversion are done
+		 * in separate branch-free loops.
+		 * @param out output buffer
+		 * @param frames amount of samples
+		 */
+		virtual void Ramp(float* out, int frames)
+		{
+			// Smoothed normalized values
+			double r = m_RValue;
+			const double target = m_Value.load(), amount = m_Data.smoothingAmount;
+			if (!m_Data.enableSmoothing)
+				std::fill(out, out + frames, (float)(r = target));
+			else if (m_Data.smoothingType == ParameterData::Smoothing::Linear)
+				for (int i = 0; i < frames; i++)
+					out[i] = r += constrain(target - r, -amount, amount);
+			else
+				for (int i = 0; i < frames; i++)
+					out[i] = r += amount * (target - r);
+			m_RValue = r;
+
+			// Convert in place
+			const Conversion c = CurrentConversion();
+			const float a = c.span, b = c.start;
+			if (m_Data.scalingType == ParameterData::Scaling::Log)
+				for (int i = 0; i < frames; i++)
+					out[i] = std::copysign(std::exp(std::abs(out[i]) * a + b), out[i]);
+			else if (m_Data.scaling == 1)
+				for (int i = 0; i < frames; i++)
+					out[i] = out[i] * a + b;
+			else
+			{
+				const float scaling = m_Data.scaling;
+				for (int i = 0; i < frames; i++)
+					out[i] = std::pow(out[i], scaling) * a + b;
+			}
+		}
 
 		/**
 		 * Set the normalized value of this Parameter.
 		 * @param v normalized value
 		 */
-		virtual void NormalizedValue(double v) { m_Value = v; ConstrainValue(); }
+		virtual void NormalizedValue(double v) { Store(v); }
+
+		/**
+		 * Set the normalized value from the audio thread, for host automation.
+		 * Doesn't notify the change queue, the UI simply shows the new value.
+		 * @param v normalized value
+		 */
+		void Automate(double v) { m_Value.store(constrain(v, 0.0, 1.0)); }
+
+		/**
+		 * Ramp with sample accurate automation, the value jumps to each event at its
+		 * offset and is smoothed from there like any other change.
+		 * @param out output buffer
+		 * @param frames amount of samples
+		 * @param events events for this Parameter, sorted by offset
+		 * @param count amount of events
+		 */
+		void Ramp(float* out, int frames, const AutomationEvent* events, int count)
+		{
+			int start = 0;
+			for (int e = 0; e <= count; e++)
+			{
+				int end = e < count ? constrain(events[e].offset, start, frames) : frames;
+				if (end > start)
+					Ramp(out + start, end - start);
+
+				if (e < count)
+					Automate(events[e].value);
+
+				start = end;
+			}
+		}
 
 		/**
 		 * Get the normalized value of this Parameter.
@@ -392,12 +716,12 @@ namespace SoundMixr
 		 * Set the reset-value of this Parameter.
 		 * @param v reset-value
 		 */
-		virtual void ResetValue(double v) { if (m_DefaultReset == NODEFAULT) m_DefaultReset = v; m_ResetValue = v; }
+		virtual void ResetValue(double v) { if (m_DefaultReset == NODEFAULT) m_DefaultReset = v; m_ResetValue = v; Touched(); }
 
 		/**
 		 * Reset the value to the reset-value of this Parameter.
 		 */
-		virtual void ResetValue() { m_Value = Normalize(m_ResetValue); }
+		virtual void ResetValue() { Store(Normalize(m_ResetValue)); }
 
 		/**
 		 * Get the default reset value of this Parameter.
@@ -423,7 +747,7 @@ namespace SoundMixr
 		 * is non-linear.
 		 * @param v power
 		 */
-		virtual void ScalingType(ParameterData::Scaling t) { m_Data.scalingType = t; }
+		virtual void ScalingType(ParameterData::Scaling t) { m_Data.scalingType = t; UpdateConversion(); Changed(); }
 
 		/**
 		 * Get the power to this parameter's value range.
@@ -435,7 +759,7 @@ namespace SoundMixr
 		 * Make the range of this parameter logarithmic.
 		 * @param v log
 		 */
-		virtual void Scaling(double v) { m_Data.scaling = v; }
+		virtual void Scaling(double v) { m_Data.scaling = v; UpdateConversion(); Changed(); }
 
 		/**
 		 * Get the power to this parameter's value range.
@@ -531,7 +855,7 @@ namespace SoundMixr
 		 * Link this Parameter to a midi control.
 		 * @param l midilink
 		 */
-		virtual void MidiLink(const MidiCCLink& l) { m_MidiLink = l; }
+		virtual void MidiLink(const MidiCCLink& l) { m_MidiLink = l; Touched(); }
 
 		/**
 		 * Get the midilink of this Parameter;
@@ -539,12 +863,12 @@ namespace SoundMixr
 		 */
 		virtual auto MidiLink() -> MidiCCLink& { return m_MidiLink; }
 
-		virtual void Default() override { m_ResetValue = m_DefaultReset; ResetValue(); m_MidiLink = { -1, -1, -1 }; }
+		virtual void Default() override { m_ResetValue = m_DefaultReset; ResetValue(); m_MidiLink = { -1, -1, -1 }; Touched(); }
 
 		virtual operator nlohmann::json() override
 		{
 			nlohmann::json _json;
-			_json["value"] = m_Value;
+			_json["value"] = m_Value.load();
 			_json["default"] = m_ResetValue;
 			_json["midilink"] = nlohmann::json::array();
 			_json["midilink"] += m_MidiLink.channel;
@@ -555,19 +879,34 @@ namespace SoundMixr
 
 		virtual void operator=(const nlohmann::json& json) override
 		{
-			m_Value = json.at("value").get<double>();
+			Store(json.at("value").get<double>());
 			m_ResetValue = json.at("default").get<double>();
 			m_MidiLink.channel = json.at("midilink")[0].get<int>();
 			m_MidiLink.control = json.at("midilink")[1].get<int>();
 			m_MidiLink.device = json.at("midilink")[2].get<int>();
 		}
 
+		virtual void Save(StateWriter& w) override
+		{
+			w.Write(m_Value.load()), w.Write(m_ResetValue);
+			w.Write(m_MidiLink.channel), w.Write(m_MidiLink.control), w.Write(m_MidiLink.device);
+		}
+
+		virtual void Load(StateReader& r) override
+		{
+			Store(r.Read(m_Value.load()));
+			r.Read(m_ResetValue);
+			r.Read(m_MidiLink.channel), r.Read(m_MidiLink.control), r.Read(m_MidiLink.device);
+		}
+
 	protected:
 		static inline double NODEFAULT = 10.1343131e30;
 
 		ParameterData m_Data;
 
-		double m_Value = 0, m_RValue = 0, 
+		std::atomic<double> m_Value = 0; // Written by the UI thread, read by the audio thread
+
+		double m_RValue = 0, 
 			m_ResetValue = 0,
 			m_DefaultReset = NODEFAULT;
 
@@ -581,54 +920,237 @@ namespace SoundMixr
 
 		const ParameterType m_Type;
 
-		void ConstrainValue() { m_Value = constrain(m_Value, 0, 1); }
+		void Store(double v) { m_Value = constrain(v, 0.0, 1.0); Changed(); }
+
+		double Smooth(double r) const
+		{
+			const double target = m_Value;
+			if (!m_Data.enableSmoothing)
+				return target;
+			if (m_Data.smoothingType == ParameterData::Smoothing::Linear)
+				return r + constrain(target - r, -m_Data.smoothingAmount, m_Data.smoothingAmount);
+			return r + m_Data.smoothingAmount * (target - r);
+		}
 
 		double Convert(double v) const
 		{
+			const Conversion c = CurrentConversion();
 			if (m_Data.scalingType == ParameterData::Scaling::Pow)
-				return std::powf(v, m_Data.scaling) * (m_Data.range.end - m_Data.range.start) + m_Data.range.start;
+				return std::powf(v, m_Data.scaling) * c.span + c.start;
 			else
 			{
-				static const auto mylog = [](double v, double b) { return std::log(v) / b; };
-				auto rs = m_Data.range.start;
-				auto re = m_Data.range.end;
-				if (rs == 0)
-					rs = 0.00000000001;
-				if (re == 0)
-					re = 0.00000000001;
+				// scaling^(log_scaling(rs) + v * (log_scaling(re) - log_scaling(rs))) == rs * (re / rs)^v
 				auto abs = v >= 0 ? v : -v;
-				auto logg = std::log(m_Data.scaling);
-				auto rslogg = mylog(rs, logg);
-
-				auto val = std::pow(m_Data.scaling, abs * (mylog(re, logg) - rslogg) + rslogg);
+				auto val = std::exp(abs * c.span + c.start);
 				return v >= 0 ? val : -val;
 			}
 		}
 
 		double Normalize(double v) const
 		{
+			const Conversion c = CurrentConversion();
 			if (m_Data.scalingType == ParameterData::Scaling::Pow)
-				return std::powf((v - m_Data.range.start) / (m_Data.range.end - m_Data.range.start), 1.0 / m_Data.scaling);
+				return std::powf((v - c.start) / c.span, 1.0 / m_Data.scaling);
+
+			if (v == 0)
+				v = 0.00000000001;
+
+			auto log = v >= 0 ? std::log(v) : std::log(-v);
+			auto norm1 = (log - c.start) / c.span;
+			return v >= 0 ? norm1 : -norm1;
+		};
+
+	private:
+		// Conversion constants, start and span of the range, or of its logarithm,
+		// and the settings they were calculated from
+		struct Conversion
+		{
+			Pair<double> range{ 0, 0 };
+			double scaling = 0;
+			ParameterData::Scaling type = ParameterData::Scaling::Pow;
+			double start = 0, span = 0;
+		};
 
-			static const auto mylog = [](double v, double b) { return std::log(v) / b; };
+		// Only written by the setters, so the audio thread never writes shared state
+		Conversion m_Conversion;
 
+		void UpdateConversion() { m_Conversion = CalculateConversion(); }
+
+		/**
+		 * The cached constants, or when m_Data was changed through the reference from
+		 * Data() a local calculation, the cache is left alone.
+		 */
+		Conversion CurrentConversion() const
+		{
+			const Conversion& c = m_Conversion;
+			if (c.range.start == m_Data.range.start && c.range.end == m_Data.range.end
+				&& c.scaling == m_Data.scaling && c.type == m_Data.scalingType)
+				return c;
+			return CalculateConversion();
+		}
+
+		Conversion CalculateConversion() const
+		{
+			Conversion c{ m_Data.range, m_Data.scaling, m_Data.scalingType };
 			auto rs = m_Data.range.start;
 			auto re = m_Data.range.end;
+			if (m_Data.scalingType == ParameterData::Scaling::Pow)
+			{
+				c.start = rs;
+				c.span = re - rs;
+				return c;
+			}
+
 			if (rs == 0)
 				rs = 0.00000000001;
 			if (re == 0)
 				re = 0.00000000001;
+			c.start = std::log(rs);
+			c.span = std::log(re) - c.start;
+			return c;
+		}
+	};
 
-			if (v == 0)
-				v = 0.00000000001;
+	/**
+	 * Level metering from the audio thread to the UI. The audio thread measures blocks with
+	 * Process() or Set() and calls Publish(), the UI calls Update() and reads the levels.
+	 * Snapshots go through a TripleBuffer so neither side waits, and only Channels() allocates.
+	 */
+	class LevelMeter
+	{
+	public:
+		struct Snapshot
+		{
+			std::vector<float> peak, rms;
+		};
 
-			auto logg = std::log(m_Data.scaling);
-			auto rslogg = mylog(rs, logg);
-			auto log = v >= 0 ? mylog(v, logg) : mylog(-v, logg);
+		double decay = 24; // Fall rate of the displayed levels in dB per second
+		double hold = 1.5; // Time the peak hold stays before decaying in seconds
 
-			auto norm1 = (log - rslogg) / (mylog(re, logg) - rslogg);
-			return v >= 0 ? norm1 : -norm1;
-		};
+		/**
+		 * Set the amount of channels, allocates. Not thread safe, so
+		 * don't call this while the audio thread is publishing.
+		 * @param n channels
+		 */
+		void Channels(int n)
+		{
+			m_Channels = n;
+			Snapshot s;
+			s.peak.assign(n, 0), s.rms.assign(n, 0);
+			m_Buffer.Initialize(s);
+			m_Peak.assign(n, 0), m_Sum.assign(n, 0), m_Count.assign(n, 0);
+			m_Level.assign(n, 0), m_Rms.assign(n, 0), m_Hold.assign(n, 0), m_HoldTime.assign(n, 0);
+		}
+
+		/**
+		 * @return amount of channels
+		 */
+		int Channels() const { return m_Channels; }
+
+		/**
+		 * Measure a block of samples of a channel, audio thread only.
+		 * @param ch channel
+		 * @param in samples
+		 * @param frames amount of samples
+		 */
+		void Process(int ch, const float* in, int frames)
+		{
+			if (ch >= m_Channels)
+				return;
+
+			float peak = m_Peak[ch], sum = 0;
+			for (int i = 0; i < frames; i++)
+				peak = std::max(peak, std::abs(in[i])), sum += in[i] * in[i];
+			m_Peak[ch] = peak, m_Sum[ch] += sum, m_Count[ch] += frames;
+		}
+
+		/**
+		 * Set the level of a channel that was measured elsewhere, audio thread only.
+		 * @param ch channel
+		 * @param peak peak level
+		 * @param rms rms level
+		 */
+		void Set(int ch, float peak, float rms)
+		{
+			if (ch >= m_Channels)
+				return;
+
+			m_Peak[ch] = peak, m_Sum[ch] = rms * rms, m_Count[ch] = 1;
+		}
+
+		/**
+		 * Publish the levels measured since the last Publish, audio thread only.
+		 * @param clear start measuring the next block from silence, pass false
+		 *              when channels are Set one at a time
+		 */
+		void Publish(bool clear = true)
+		{
+			Snapshot& s = m_Buffer.Write();
+			for (int ch = 0; ch < m_Channels; ch++)
+			{
+				s.peak[ch] = m_Peak[ch];
+				s.rms[ch] = m_Count[ch] ? std::sqrt(m_Sum[ch] / m_Count[ch]) : 0;
+				if (clear)
+					m_Peak[ch] = 0, m_Sum[ch] = 0, m_Count[ch] = 0;
+			}
+			m_Buffer.Publish();
+		}
+
+		/**
+		 * Take the newest snapshot and advance the peak hold and decay, UI thread only.
+		 * @param dt seconds since the last Update
+		 * @return true when there was a new snapshot
+		 */
+		bool Update(double dt = 0)
+		{
+			const bool fresh = m_Buffer.Update();
+			const Snapshot& s = m_Buffer.Read();
+			const float fall = std::pow(10.0, -decay * dt / 20);
+			for (int ch = 0; ch < m_Channels; ch++)
+			{
+				// Without a new snapshot the levels only decay
+				const float peak = fresh ? s.peak[ch] : 0, rms = fresh ? s.rms[ch] : 0;
+				m_Level[ch] = std::max(peak, m_Level[ch] * fall);
+				m_Rms[ch] = std::max(rms, m_Rms[ch] * fall);
+				if (peak >= m_Hold[ch])
+					m_Hold[ch] = peak, m_HoldTime[ch] = hold;
+				else if ((m_HoldTime[ch] -= dt) < 0)
+					m_Hold[ch] = std::max(m_Level[ch], m_Hold[ch] * fall);
+			}
+			return fresh;
+		}
+
+		/**
+		 * @return the newest snapshot taken by Update, without ballistics
+		 */
+		const Snapshot& Latest() const { return m_Buffer.Read(); }
+
+		/**
+		 * @return decaying peak levels
+		 */
+		const std::vector<float>& Peak() const { return m_Level; }
+
+		/**
+		 * @return decaying rms levels
+		 */
+		const std::vector<float>& Rms() const { return m_Rms; }
+
+		/**
+		 * @return peak hold levels
+		 */
+		const std::vector<float>& Hold() const { return m_Hold; }
+
+	private:
+		int m_Channels = 0;
+		TripleBuffer<Snapshot> m_Buffer;
+
+		// Audio thread
+		std::vector<float> m_Peak, m_Sum;
+		std::vector<int> m_Count;
+
+		// UI thread
+		std::vector<float> m_Level, m_Rms, m_Hold;
+		std::vector<double> m_HoldTime;
 	};
 
 	/**
@@ -655,13 +1177,8 @@ namespace SoundMixr
 				return;
 
 			m_Channels = n;
-			m_Values.reserve(n);
-			while (m_Values.size() < n)
-				m_Values.push_back(0);
-
-			m_Reduces.reserve(n);
-			while (m_Reduces.size() < n)
-				m_Reduces.push_back(0);
+			m_Meter.Channels(n);
+			m_ReduceMeter.Channels(n);
 		}
 
 		/**
@@ -671,37 +1188,66 @@ namespace SoundMixr
 		int Channels() { return m_Channels; }
 
 		/**
-		 * Get the list of levels of all channels in this VolumeSlider.
-		 * These will be displayed behind the adjusted levels.
+		 * Take the newest levels and adjusted levels, UI thread only.
+		 * @param dt seconds since the last Update
+		 * @return true when there were new levels
+		 */
+		bool Update(double dt = 0)
+		{
+			const bool levels = m_Meter.Update(dt);
+			return m_ReduceMeter.Update(dt) || levels;
+		}
+
+		/**
+		 * Get the list of levels of all channels in this VolumeSlider, as taken
+		 * by Update. These will be displayed behind the adjusted levels.
 		 * @return levels
 		 */
-		auto Values() -> std::vector<float> { return m_Values; }
+		auto Values() const -> const std::vector<float>& { return m_Meter.Latest().peak; }
 
 		/**
-		 * Get the list of adjusted levels of all channels in this VolumeSlider.
-		 * These will be displayed in front of the levels.
+		 * Get the list of adjusted levels of all channels in this VolumeSlider, as
+		 * taken by Update. These will be displayed in front of the levels.
 		 * @return adjusted levels
 		 */
-		auto Reduces() -> std::vector<float> { return m_Reduces; }
+		auto Reduces() const -> const std::vector<float>& { return m_ReduceMeter.Latest().peak; }
 
 		/**
-		 * Set a level for channel i.
+		 * Set a level for channel i, audio thread only. Call Publish once the
+		 * block is done.
 		 * @param i channel
 		 * @param v level
 		 */
-		void SetValue(int i, float v) { m_Values[i] = v; }
+		void SetValue(int i, float v) { m_Meter.Set(i, v, v); }
 
 		/**
-		 * Set an adjusted level for channel i.
+		 * Set an adjusted level for channel i, audio thread only. Call Publish
+		 * once the block is done.
 		 * @param i channel
 		 * @param v adjusted level
 		 */
-		void SetReduce(int i, float v) { m_Reduces[i] = v; }
+		void SetReduce(int i, float v) { m_ReduceMeter.Set(i, v, v); }
+
+		/**
+		 * Publish the levels and adjusted levels of all channels, once per block on
+		 * the audio thread. Channels that weren't set keep their level.
+		 */
+		void Publish() { m_Meter.Publish(false), m_ReduceMeter.Publish(false); }
+
+		/**
+		 * @return meter of the levels
+		 */
+		LevelMeter& Meter() { return m_Meter; }
+
+		/**
+		 * @return meter of the adjusted levels
+		 */
+		LevelMeter& ReduceMeter() { return m_ReduceMeter; }
 
 	private:
 		int m_Channels = 0;
-		std::vector<float> m_Values;
-		std::vector<float> m_Reduces;
+		LevelMeter m_Meter;
+		LevelMeter m_ReduceMeter;
 	};
 
 	/**
@@ -709,6 +1255,7 @@ namespace SoundMixr
 	 */
 	class DropDown : public Object
 	{
+		friend class PresetMorph;
 	public:
 
 		DropDown(const std::string& name)
@@ -745,6 +1292,7 @@ namespace SoundMixr
 			if (m_Selected == -1)
 				m_Selected = (int)i;
 			m_Options.emplace_back(name, (int)i);
+			Changed();
 		}
 
 		/**
@@ -757,6 +1305,7 @@ namespace SoundMixr
 				m_Default = i;
 
 			m_Selected = i;
+			Changed();
 		}
 
 		/**
@@ -780,7 +1329,7 @@ namespace SoundMixr
 		operator nlohmann::json() override
 		{
 			nlohmann::json _json;
-			_json["selected"] = m_Selected;
+			_json["selected"] = m_Selected.load();
 			return _json;
 		}
 
@@ -789,11 +1338,14 @@ namespace SoundMixr
 			Select(json.at("selected").get<int>());
 		}
 
+		void Save(StateWriter& w) override { w.Write(m_Selected.load()); }
+		void Load(StateReader& r) override { Select(r.Read(m_Selected.load())); }
+
 		virtual void Default() override { Select(m_Default); }
 
 	private:
 		std::string m_Name;
-		int m_Selected = -1;
+		std::atomic<int> m_Selected = -1;
 		int m_Default = -1;
 		std::vector<Option> m_Options;
 	};
@@ -817,7 +1369,7 @@ namespace SoundMixr
 		 * Set the state of this button.
 		 * @param s state
 		 */
-		void State(bool s) { if (m_Default == -1) m_Default = s; state = s; }
+		void State(bool s) { if (m_Default == -1) m_Default = s; state = s; Changed(); }
 
 		/**
 		 * Get the state of this button.
@@ -832,14 +1384,15 @@ namespace SoundMixr
 		auto Name() -> std::string& { return m_Name; }
 
 		/**
-		 * The state of this toggle button.
+		 * The state of this toggle button, use State(bool s) when changing it
+		 * so the audio thread is notified.
 		 */
-		bool state = false;
+		std::atomic<bool> state = false;
 
 		operator nlohmann::json() override
 		{
 			nlohmann::json _json;
-			_json["state"] = state;
+			_json["state"] = state.load();
 			return _json;
 		}
 
@@ -848,6 +1401,9 @@ namespace SoundMixr
 			State(json.at("state").get<bool>());
 		}
 
+		void Save(StateWriter& w) override { w.Write(state.load()); }
+		void Load(StateReader& r) override { State(r.Read(state.load())); }
+
 		virtual void Default() override { State(m_Default); }
 
 	private:
@@ -877,7 +1433,7 @@ namespace SoundMixr
 		 * Will call the callback!
 		 * @param s select
 		 */
-		void Selected(bool s) { selected = s; if (s) Callback(); }
+		void Selected(bool s) { selected = s; Touched(); if (s) Callback(); }
 
 		/**
 		 * Returns true when this button is selected.
@@ -921,6 +1477,9 @@ namespace SoundMixr
 			Selected(s);
 		}
 
+		void Save(StateWriter& w) override { w.Write(selected); }
+		void Load(StateReader& r) override { Selected(r.Read(selected)); }
+
 	private:
 		int m_Id;
 		std::string m_Name;
@@ -971,8 +1530,20 @@ namespace SoundMixr
 			return m_Parameters;
 		}
 
+		/**
+		 * Get the combined response of all bands, only bands whose coefficients
+		 * changed since the last call are recalculated. UI thread only.
+		 * @return response
+		 */
+		FrequencyResponse& Response()
+		{
+			m_Response.Update(m_Parameters);
+			return m_Response;
+		}
+
 	private:
 		std::vector<BiquadParameters>& m_Parameters;
+		FrequencyResponse m_Response;
 	};
 
 	class SimpleFilterCurve : public Object
@@ -987,9 +1558,237 @@ namespace SoundMixr
 			return m_Parameters.Parameters();
 		}
 
-		Parameter& width, & freq;
-
-		SimpleFilterParameters& m_Parameters;
+		/**
+		 * Get the combined response of both filters, UI thread only.
+		 * @return response
+		 */
+		FrequencyResponse& Response()
+		{
+			m_Response.Update(m_Parameters.Parameters());
+			return m_Response;
+		}
+
+		Parameter& width, & freq;
+
+		SimpleFilterParameters& m_Parameters;
+		FrequencyResponse m_Response;
+	};
+
+	/**
+	 * Spectrum display. The audio thread pushes samples into a lock-free ring, a worker
+	 * thread calculates Hann windowed FFTs of the newest Size() samples at FrameRate(),
+	 * bins them into log-spaced bands, smooths them and publishes them to the UI.
+	 */
+	class SpectrumAnalyzer : public Object
+	{
+	public:
+		static constexpr int MaxSize = 16384;
+
+		/**
+		 * Constructor.
+		 * @param size fft size, power of 2 up to MaxSize
+		 * @param bins amount of log-spaced output bins
+		 * @param sampleRate samplerate
+		 */
+		SpectrumAnalyzer(int size = 4096, int bins = 256, double sampleRate = 48000)
+		{
+			Configure(size, bins, sampleRate);
+		}
+
+		~SpectrumAnalyzer() { Stop(); }
+
+		/**
+		 * Set the fft size, amount of bins and samplerate, allocates and restarts the worker.
+		 * Not called from the audio thread, pushing samples meanwhile is safe.
+		 * @param size fft size, rounded up to a power of 2 from 64 up to MaxSize
+		 * @param bins amount of log-spaced output bins
+		 * @param sampleRate samplerate
+		 */
+		void Configure(int size, int bins, double sampleRate)
+		{
+			Stop();
+			m_Size = 64;
+			while (m_Size < std::min(size, MaxSize))
+				m_Size *= 2;
+			m_Bins = std::max(bins, 1), m_SampleRate = sampleRate;
+			m_FFT.Size(m_Size);
+			m_History.assign(m_Size, 0), m_Frame.resize(m_Size), m_Spectrum.resize(m_Size / 2 + 1);
+			m_Incoming.resize(m_Ring.Capacity());
+			m_Window.resize(m_Size);
+			for (int i = 0; i < m_Size; i++)
+				m_Window[i] = 0.5 - 0.5 * std::cos(6.28318530718 * i / m_Size);
+
+			// Bin edges as fractional fft bins, narrow bins interpolate between fft bins
+			m_Frequencies.resize(m_Bins), m_Edges.resize(m_Bins + 1);
+			const double low = 20, high = sampleRate / 2, ratio = std::log(high / low) / m_Bins;
+			for (int b = 0; b <= m_Bins; b++)
+				m_Edges[b] = low * std::exp(ratio * b) * m_Size / sampleRate;
+			for (int b = 0; b < m_Bins; b++)
+				m_Frequencies[b] = low * std::exp(ratio * (b + 0.5));
+
+			m_Smoothed.assign(m_Bins, -144);
+			m_Buffer.Initialize(m_Smoothed);
+			Start();
+		}
+
+		/**
+		 * Set the samplerate, reconfigures when changed.
+		 * @param r samplerate
+		 */
+		void SampleRate(double r) { if (r != m_SampleRate) Configure(m_Size, m_Bins, r); }
+
+		/**
+		 * Set the amount of spectra calculated per second.
+		 * @param f frame rate
+		 */
+		void FrameRate(double f) { m_FrameRate = std::clamp(f, 1.0, 240.0); }
+		double FrameRate() const { return m_FrameRate; }
+
+		/**
+		 * Set the smoothing between frames, 0 is none, close to 1 is a lot.
+		 * @param s smoothing
+		 */
+		void Smoothing(double s) { m_Smoothing = std::clamp(s, 0.0, 0.99); }
+		double Smoothing() const { return m_Smoothing; }
+
+		/**
+		 * @return fft size
+		 */
+		int Size() const { return m_Size; }
+
+		/**
+		 * Push samples, audio thread only. Samples that don't fit are dropped.
+		 * @param in samples
+		 * @param frames amount of samples
+		 */
+		void Push(const float* in, int frames) { m_Ring.Push(in, frames); }
+
+		/**
+		 * Push the average of several channels, audio thread only.
+		 * @param in buffers, one per channel
+		 * @param channels amount of channels
+		 * @param frames amount of samples per channel
+		 */
+		void Push(const float* const* in, int channels, int frames)
+		{
+			float mix[64];
+			const float gain = 1.0f / std::max(channels, 1);
+			for (int offset = 0; offset < frames; offset += 64)
+			{
+				int n = std::min(64, frames - offset);
+				std::fill(mix, mix + n, 0.0f);
+				for (int c = 0; c < channels; c++)
+					for (int i = 0; i < n; i++)
+						mix[i] += in[c][offset + i] * gain;
+				m_Ring.Push(mix, n);
+			}
+		}
+
+		/**
+		 * Take the newest spectrum, UI thread only.
+		 * @return true when there was a new spectrum
+		 */
+		bool Update() { return m_Buffer.Update(); }
+
+		/**
+		 * @return magnitudes of the newest spectrum taken by Update in dB, one per bin
+		 */
+		const std::vector<float>& Magnitudes() const { return m_Buffer.Read(); }
+
+		/**
+		 * @return centre frequency of each bin in Hz
+		 */
+		const std::vector<float>& Frequencies() const { return m_Frequencies; }
+
+	private:
+		SPSCQueue<float, 2 * MaxSize> m_Ring;
+		TripleBuffer<std::vector<float>> m_Buffer;
+		std::thread m_Worker;
+		std::atomic<bool> m_Running{ false };
+		std::atomic<double> m_FrameRate{ 30 };
+		std::atomic<double> m_Smoothing{ 0.7 };
+
+		// Worker thread, set up in Configure
+		int m_Size = 0, m_Bins = 0;
+		double m_SampleRate = 0;
+		RealFFT m_FFT;
+		std::vector<float> m_History, m_Incoming, m_Frame, m_Window, m_Smoothed, m_Frequencies;
+		std::vector<double> m_Edges;
+		std::vector<RealFFT::Complex> m_Spectrum;
+
+		void Start()
+		{
+			m_Running = true;
+			m_Worker = std::thread([this] {
+				using Clock = std::chrono::steady_clock;
+				auto next = Clock::now();
+				while (m_Running)
+				{
+					Analyze();
+
+					// Frames start at a fixed rate, however long Analyze took, but
+					// when it falls behind it doesn't try to catch up
+					next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_FrameRate));
+					next = std::max(next, Clock::now());
+					std::this_thread::sleep_until(next);
+				}
+			});
+		}
+
+		void Stop()
+		{
+			m_Running = false;
+			if (m_Worker.joinable())
+				m_Worker.join();
+		}
+
+		void Analyze()
+		{
+			// Take all new samples at once, then shift them into the history, keeping
+			// the newest Size() samples
+			const int n = static_cast<int>(m_Ring.Pop(m_Incoming.data(), m_Incoming.size()));
+			if (n == 0)
+				return;
+
+			float* h = m_History.data();
+			const int keep = std::max(m_Size - n, 0);
+			std::copy(h + m_Size - keep, h + m_Size, h);
+			std::copy(m_Incoming.data() + n - (m_Size - keep), m_Incoming.data() + n, h + keep);
+
+			for (int i = 0; i < m_Size; i++)
+				m_Frame[i] = h[i] * m_Window[i];
+			m_FFT.Forward(m_Frame.data(), m_Spectrum.data());
+
+			// Power per fft bin, scaled so a full scale sine is 0 dB
+			const int last = m_Size / 2;
+			const float scale = 16.0f / ((float)m_Size * m_Size);
+			for (int k = 0; k <= last; k++)
+				m_Frame[k] = std::norm(m_Spectrum[k]) * scale;
+
+			const float s = m_Smoothing;
+			std::vector<float>& out = m_Buffer.Write();
+			for (int b = 0; b < m_Bins; b++)
+			{
+				const double lo = m_Edges[b], hi = m_Edges[b + 1];
+				const int first = (int)std::ceil(lo), end = std::min((int)std::floor(hi), last);
+				float power = 0;
+				if (end >= first)
+					for (int k = first; k <= end; k++)
+						power = std::max(power, m_Frame[k]);
+				else
+				{
+					const double c = std::min(0.5 * (lo + hi), (double)last - 1);
+					const int k = (int)c;
+					const float f = c - k;
+					power = m_Frame[k] + (m_Frame[k + 1] - m_Frame[k]) * f;
+				}
+
+				const float db = 10 * std::log10(std::max(power, 1e-15f));
+				m_Smoothed[b] = s * m_Smoothed[b] + (1 - s) * db;
+				out[b] = m_Smoothed[b];
+			}
+			m_Buffer.Publish();
+		}
 	};
 
 	/**
@@ -998,47 +1797,52 @@ namespace SoundMixr
 	class DynamicsSlider : public Object
 	{
 	public:
-		void   ExpanderThreshhold(double v) { expanderThreshhold = v; }
+		void   ExpanderThreshhold(double v) { expanderThreshhold = v; Changed(); }
 		double ExpanderThreshhold() { return expanderThreshhold; }
-		void   CompressorThreshhold(double v) { compressThreshhold = v; }
+		void   CompressorThreshhold(double v) { compressThreshhold = v; Changed(); }
 		double CompressorThreshhold() { return compressThreshhold; }
-		void   ExpanderRatio(double r) { expanderRatio = r; }
+		void   ExpanderRatio(double r) { expanderRatio = r; Changed(); }
 		double ExpanderRatio() { return expanderRatio; }
-		void   CompressorRatio(double r) { compressRatio = r; }
+		void   CompressorRatio(double r) { compressRatio = r; Changed(); }
 		double CompressorRatio() { return compressRatio; }
-		void   AttackTime(double a) { attms = a; }
+		void   AttackTime(double a) { attms = a; Changed(); }
 		double AttackTime() { return attms; }
-		void   ReleaseTime(double a) { relms = a; }
+		void   ReleaseTime(double a) { relms = a; Changed(); }
 		double ReleaseTime() { return relms; }
-		void   PreGain(double a) { pregain = a; }
+		void   PreGain(double a) { pregain = a; Changed(); }
 		double PreGain() { return pregain; }
-		void   PostGain(double a) { postgain = a; }
+		void   PostGain(double a) { postgain = a; Changed(); }
 		double PostGain() { return postgain; }
-		void   Mix(double a) { mix = a; }
+		void   Mix(double a) { mix = a; Changed(); }
 		double Mix() { return mix; }
+		void   Lookahead(double a) { lookahead = a; Changed(); }
+		double Lookahead() { return lookahead; }
 		double Channels() { return channels; }
-		auto   Levels() -> std::vector<float>& { return levels; }
-		void   Level(int i, float v) { levels[i] = v; }
+		auto   Levels() const -> const std::vector<float>& { return meter.Latest().peak; } // As taken by Update
+		void   Level(int i, float v) { meter.Set(i, v, v); } // Audio thread, Publish once per block
+		void   Publish() { meter.Publish(false); }
+		bool   Update(double dt = 0) { return meter.Update(dt); } // UI thread
+		auto   Meter() -> LevelMeter& { return meter; }
 
 		void Channels(int i)
 		{
 			channels = i;
-			while (levels.size() < i)
-				levels.push_back(0);
+			meter.Channels(i);
 		}
 
 		operator nlohmann::json() override
 		{
 			nlohmann::json _json;
-			_json["expanderThreshhold"] = expanderThreshhold;
-			_json["compressThreshhold"] = compressThreshhold;
-			_json["expanderRatio"] = expanderRatio;
-			_json["compressRatio"] = compressRatio;
-			_json["attms"] = attms;
-			_json["relms"] = relms;
-			_json["pregain"] = pregain;
-			_json["postgain"] = postgain;
-			_json["mix"] = mix;
+			_json["expanderThreshhold"] = expanderThreshhold.load();
+			_json["compressThreshhold"] = compressThreshhold.load();
+			_json["expanderRatio"] = expanderRatio.load();
+			_json["compressRatio"] = compressRatio.load();
+			_json["attms"] = attms.load();
+			_json["relms"] = relms.load();
+			_json["pregain"] = pregain.load();
+			_json["postgain"] = postgain.load();
+			_json["mix"] = mix.load();
+			_json["lookahead"] = lookahead.load();
 			return _json;
 		}
 
@@ -1053,6 +1857,23 @@ namespace SoundMixr
 			pregain = json.at("pregain").get<double>();
 			postgain = json.at("postgain").get<double>();
 			mix = json.at("mix").get<double>();
+			lookahead = json.value("lookahead", 0.0);
+			Changed();
+		}
+
+		void Save(StateWriter& w) override
+		{
+			for (auto* v : { &expanderThreshhold, &compressThreshhold, &expanderRatio, &compressRatio,
+				&attms, &relms, &pregain, &postgain, &mix, &lookahead })
+				w.Write(v->load());
+		}
+
+		void Load(StateReader& r) override
+		{
+			for (auto* v : { &expanderThreshhold, &compressThreshhold, &expanderRatio, &compressRatio,
+				&attms, &relms, &pregain, &postgain, &mix, &lookahead })
+				*v = r.Read(v->load());
+			Changed();
 		}
 
 		virtual void Default() override
@@ -1068,23 +1889,173 @@ namespace SoundMixr
 			pregain = 0;
 			postgain = 0;
 			mix = 0;
+			lookahead = 0;
+			Changed();
 		}
 
 	private:
-		double expanderThreshhold = -50;
-		double compressThreshhold = -10;
-		double expanderRatio = 0;
-		double compressRatio = 0;
+		// Written by the UI thread, read by the audio thread
+		std::atomic<double> expanderThreshhold = -50;
+		std::atomic<double> compressThreshhold = -10;
+		std::atomic<double> expanderRatio = 0;
+		std::atomic<double> compressRatio = 0;
 
-		double attms = 1;
-		double relms = 100;
+		std::atomic<double> attms = 1;
+		std::atomic<double> relms = 100;
 
-		double pregain = 0;
-		double postgain = 0;
-		double mix = 0;
+		std::atomic<double> pregain = 0;
+		std::atomic<double> postgain = 0;
+		std::atomic<double> mix = 0;
+
+		std::atomic<double> lookahead = 0; // ms
 
 		int channels = 0;
-		std::vector<float> levels;
+		LevelMeter meter;
+	};
+
+	/**
+	 * DynamicsSlider for a band of a multiband compressor, also stores the
+	 * crossover frequency above the band.
+	 */
+	class MultibandSlider : public DynamicsSlider
+	{
+	public:
+		MultibandSlider(int band)
+			: band(band)
+		{}
+
+		int    Band() { return band; }
+		void   Crossover(double f) { crossover = f; Changed(); }
+		double Crossover() { return crossover; }
+
+		operator nlohmann::json() override
+		{
+			nlohmann::json _json = DynamicsSlider::operator nlohmann::json();
+			_json["crossover"] = crossover.load();
+			return _json;
+		}
+
+		void operator=(const nlohmann::json& json) override
+		{
+			DynamicsSlider::operator=(json);
+			crossover = json.value("crossover", crossover.load());
+			Changed();
+		}
+
+		void Save(StateWriter& w) override
+		{
+			DynamicsSlider::Save(w);
+			w.Write(crossover.load());
+		}
+
+		void Load(StateReader& r) override
+		{
+			DynamicsSlider::Load(r);
+			crossover = r.Read(crossover.load());
+			Changed();
+		}
+
+	private:
+		int band = 0;
+		std::atomic<double> crossover = 1000;
+	};
+
+	/**
+	 * Owns the Objects of a plugin. Objects are constructed back to back in large aligned
+	 * blocks in declaration order, and destroyed in reverse order.
+	 */
+	class ObjectArena
+	{
+	public:
+		static constexpr size_t BlockSize = 16384;
+		static constexpr size_t Alignment = 64;
+
+		ObjectArena() = default;
+		ObjectArena(const ObjectArena&) = delete;
+		ObjectArena& operator=(const ObjectArena&) = delete;
+		~ObjectArena() { Clear(); }
+
+		/**
+		 * Construct an Object in the arena.
+		 * @param args constructor arguments
+		 * @return the object
+		 */
+		template<typename T, typename ...Args>
+		T* Create(Args&& ...args)
+		{
+			static_assert(std::is_base_of_v<Object, T>);
+			static_assert(alignof(T) <= Alignment);
+			T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			m_Objects.push_back({ object, false });
+			return object;
+		}
+
+		/**
+		 * Take ownership of an Object that was allocated elsewhere.
+		 * @param object object
+		 * @return the object
+		 */
+		template<typename T>
+		T* Adopt(std::unique_ptr<T> object)
+		{
+			T* ptr = object.release();
+			m_Objects.push_back({ ptr, true });
+			return ptr;
+		}
+
+		/**
+		 * Destroy all Objects, in reverse order of creation.
+		 */
+		void Clear()
+		{
+			for (auto i = m_Objects.rbegin(); i != m_Objects.rend(); ++i)
+				if (i->second)
+					delete i->first;
+				else
+					i->first->~Object();
+			m_Objects.clear();
+
+			for (void* block : m_Blocks)
+				::operator delete(block, std::align_val_t{ Alignment });
+			m_Blocks.clear();
+			m_Current = nullptr, m_Left = 0;
+		}
+
+	private:
+		std::vector<std::pair<Object*, bool>> m_Objects; // Object, allocated elsewhere
+		std::vector<void*> m_Blocks;
+		uint8_t* m_Current = nullptr;
+		size_t m_Left = 0;
+
+		void* Allocate(size_t size, size_t align)
+		{
+			// Objects larger than a quarter block get their own block
+			if (size > BlockSize / 4)
+				return m_Blocks.emplace_back(::operator new(size, std::align_val_t{ Alignment }));
+
+			size_t pad = (align - reinterpret_cast<uintptr_t>(m_Current) % align) % align;
+			if (!m_Current || pad + size > m_Left)
+			{
+				m_Current = static_cast<uint8_t*>(m_Blocks.emplace_back(::operator new(BlockSize, std::align_val_t{ Alignment })));
+				m_Left = BlockSize, pad = 0;
+			}
+
+			void* ptr = m_Current + pad;
+			m_Current += pad + size, m_Left -= pad + size;
+			return ptr;
+		}
+	};
+
+	/**
+	 * Typed id of an Object in a plugin, resolved in O(1) by PluginBase::Get
+	 * without a dynamic_cast.
+	 */
+	template<typename T>
+	struct Handle
+	{
+		int id = -1;
+
+		explicit operator bool() const { return id >= 0; }
 	};
 
 	/**
@@ -1100,7 +2071,9 @@ namespace SoundMixr
 		 */
 		PluginBase(const std::string& name) :
 			m_Name(name)
-		{};
+		{
+			m_Changed.reserve(ChangeQueue::Capacity());
+		};
 
 		virtual ~PluginBase() {}
 
@@ -1119,6 +2092,40 @@ namespace SoundMixr
 		 */
 		virtual void Channels(int c) {}
 
+		/**
+		 * Collect the Objects changed by the UI thread since the last call, call this
+		 * once at the top of each block on the audio thread. Doesn't allocate. When
+		 * the queue overflowed since the last call all Objects are returned.
+		 * @return ids of the changed Objects, index into Objects()
+		 */
+		const std::vector<int>& DrainChanges()
+		{
+			m_Changed.clear();
+			const bool resync = m_Resync.exchange(false, std::memory_order_acquire);
+			int id;
+			while (m_Changes.Pop(id))
+			{
+				m_PluginObjects[id]->Acknowledge();
+				if (!resync)
+					m_Changed.push_back(id);
+			}
+
+			if (resync)
+				for (id = 0; id < static_cast<int>(m_PluginObjects.size()); id++)
+				{
+					m_PluginObjects[id]->Acknowledge();
+					m_Changed.push_back(id);
+				}
+			return m_Changed;
+		}
+
+		/**
+		 * Latency in samples this plugin adds to the signal, used by the host for
+		 * delay compensation.
+		 * @return latency in samples
+		 */
+		virtual int Latency() { return 0; }
+
 		/**
 		 * This operator is used to save the settings of this Effect.
 		 */
@@ -1147,6 +2154,132 @@ namespace SoundMixr
 			Update();
 		};
 
+		static constexpr uint32_t StateMagic = 0x42584D53; // "SMXB"
+		static constexpr uint16_t StateVersion = 1;
+
+		/**
+		 * Save the settings of this Effect in the compact binary format. Nothing is
+		 * allocated, when the buffer is too small nothing useful is written.
+		 * @param data buffer, may be nullptr to only calculate the size
+		 * @param size size of the buffer in bytes
+		 * @return size of the state in bytes, larger than size when it didn't fit
+		 */
+		virtual size_t Save(uint8_t* data, size_t size)
+		{
+			StateWriter w{ data, size };
+			w.Write(StateMagic), w.Write(StateVersion);
+			w.Write(static_cast<uint32_t>(m_PluginObjects.size()));
+			for (auto& i : m_PluginObjects)
+			{
+				size_t at = w.Begin();
+				i->Save(w);
+				w.End(at);
+			}
+			return w.Size();
+		}
+
+		/**
+		 * Get the size of the binary state.
+		 * @return size in bytes
+		 */
+		size_t StateSize() { return Save(nullptr, 0); }
+
+		static constexpr uint32_t DeltaMagic = 0x44584D53; // "SMXD"
+
+		/**
+		 * Get the current generation, every change to an Object advances it. Read this
+		 * before SaveDelta and pass it to the next SaveDelta, so changes made while saving
+		 * end up in the next delta.
+		 * @return generation
+		 */
+		uint64_t Generation() const { return m_Clock.load(std::memory_order_acquire); }
+
+		/**
+		 * Save only the Objects that changed after a generation, in the binary format.
+		 * Like Save, nothing is allocated and a nullptr buffer only calculates the size.
+		 * @param since generation of the previous save, 0 for everything that was changed
+		 * @param data buffer, may be nullptr to only calculate the size
+		 * @param size size of the buffer in bytes
+		 * @return size of the delta in bytes, larger than size when it didn't fit
+		 */
+		virtual size_t SaveDelta(uint64_t since, uint8_t* data, size_t size)
+		{
+			StateWriter w{ data, size };
+			w.Write(DeltaMagic), w.Write(StateVersion);
+			size_t count = w.Size();
+			uint32_t n = 0;
+			w.Write(n);
+			for (auto& i : m_PluginObjects)
+			{
+				if (i->Generation() <= since)
+					continue;
+
+				w.Write(static_cast<uint32_t>(i->ObjectId()));
+				size_t at = w.Begin();
+				i->Save(w);
+				w.End(at);
+				n++;
+			}
+
+			if (data && count + sizeof(n) <= size)
+				std::memcpy(data + count, &n, sizeof(n));
+			return w.Size();
+		}
+
+		/**
+		 * Apply a delta saved by SaveDelta on top of the current state.
+		 * @param data delta
+		 * @param size size of the delta in bytes
+		 * @return false when this isn't a delta this version can read
+		 */
+		virtual bool LoadDelta(const uint8_t* data, size_t size)
+		{
+			StateReader r{ data, size };
+			uint32_t magic = 0, count = 0;
+			uint16_t version = 0;
+			if (!r.Read(magic) || !r.Read(version) || !r.Read(count) || magic != DeltaMagic || version > StateVersion)
+				return false;
+
+			for (uint32_t n = 0; n < count; n++)
+			{
+				uint32_t index = 0;
+				if (!r.Read(index))
+					break;
+
+				size_t end = r.Begin();
+				if (index < m_PluginObjects.size())
+					m_PluginObjects[index]->Load(r);
+				r.End(end);
+			}
+			Update();
+			return r.Good();
+		}
+
+		/**
+		 * Load settings saved by Save. Objects missing from the state keep their values,
+		 * extra objects in the state are ignored.
+		 * @param data state
+		 * @param size size of the state in bytes
+		 * @return false when this isn't a state this version can read
+		 */
+		virtual bool Load(const uint8_t* data, size_t size)
+		{
+			StateReader r{ data, size };
+			uint32_t magic = 0, count = 0;
+			uint16_t version = 0;
+			if (!r.Read(magic) || !r.Read(version) || !r.Read(count) || magic != StateMagic || version > StateVersion)
+				return false;
+
+			for (uint32_t index = 0; index < count && index < m_PluginObjects.size(); index++)
+			{
+				size_t end = r.Begin();
+				m_PluginObjects[index]->Load(r);
+				r.End(end);
+			}
+			Update();
+			return r.Good();
+		}
+
 		/**
 		 * Set the samplerate.
 		 * @param s samplerate
@@ -1202,7 +2335,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::Parameter& Parameter(const std::string& name, ParameterType type)
 		{
-			return dynamic_cast<SoundMixr::Parameter&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::Parameter>(name, type)));
+			return Named(Add<SoundMixr::Parameter>(name, type), name);
 		}
 
 		/**
@@ -1210,7 +2343,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::DropDown& DropDown(const std::string& name = "")
 		{
-			return dynamic_cast<SoundMixr::DropDown&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::DropDown>(name)));
+			return Named(Add<SoundMixr::DropDown>(name), name);
 		}
 
 		/**
@@ -1219,7 +2352,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::ToggleButton& Toggle(const std::string& name)
 		{
-			return dynamic_cast<SoundMixr::ToggleButton&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::ToggleButton>(name)));
+			return Named(Add<SoundMixr::ToggleButton>(name), name);
 		}
 
 		/**
@@ -1227,7 +2360,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::VolumeSlider& VolumeSlider()
 		{
-			return dynamic_cast<SoundMixr::VolumeSlider&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::VolumeSlider>()));
+			return Add<SoundMixr::VolumeSlider>();
 		}
 
 		/**
@@ -1235,7 +2368,16 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::DynamicsSlider& DynamicsSlider()
 		{
-			return dynamic_cast<SoundMixr::DynamicsSlider&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::DynamicsSlider>()));
+			return Add<SoundMixr::DynamicsSlider>();
+		}
+
+		/**
+		 * Emplace a MultibandSlider.
+		 * @param band band index
+		 */
+		virtual SoundMixr::MultibandSlider& MultibandSlider(int band)
+		{
+			return Add<SoundMixr::MultibandSlider>(band);
 		}
 
 		/**
@@ -1246,7 +2388,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::RadioButton& RadioButton(const std::string& name, int id, std::function<void()> callback = [] {})
 		{
-			return dynamic_cast<SoundMixr::RadioButton&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::RadioButton>(name, id, callback)));
+			return Named(Add<SoundMixr::RadioButton>(name, id, callback), name);
 		}
 
 		/**
@@ -1256,7 +2398,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::XYController& XYController(SoundMixr::Parameter& p1, SoundMixr::Parameter& p2)
 		{
-			return dynamic_cast<SoundMixr::XYController&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::XYController>(p1, p2)));
+			return Add<SoundMixr::XYController>(p1, p2);
 		}
 
 		/**
@@ -1265,7 +2407,7 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::FilterCurve& FilterCurve(std::vector<BiquadParameters>& p2)
 		{
-			return dynamic_cast<SoundMixr::FilterCurve&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::FilterCurve>(p2)));
+			return Add<SoundMixr::FilterCurve>(p2);
 		}
 
 		/**
@@ -1274,24 +2416,486 @@ namespace SoundMixr
 		 */
 		virtual SoundMixr::SimpleFilterCurve& SimpleFilterCurve(SimpleFilterParameters& p2, SoundMixr::Parameter& width, SoundMixr::Parameter& freq)
 		{
-			return dynamic_cast<SoundMixr::SimpleFilterCurve&>(*m_PluginObjects.emplace_back(std::make_unique<SoundMixr::SimpleFilterCurve>(p2, width, freq)));
+			return Add<SoundMixr::SimpleFilterCurve>(p2, width, freq);
+		}
+
+		/**
+		 * Emplace a SpectrumAnalyzer at the current samplerate.
+		 * @param size fft size
+		 * @param bins amount of log-spaced bins
+		 */
+		virtual SoundMixr::SpectrumAnalyzer& SpectrumAnalyzer(int size = 4096, int bins = 256)
+		{
+			return Add<SoundMixr::SpectrumAnalyzer>(size, bins, m_SampleRate);
 		}
 
 		/**
 		 * Get all objects in this Effect.
 		 * @return objects
 		 */
-		virtual std::vector<std::unique_ptr<SoundMixr::Object>>& Objects()
+		virtual std::vector<SoundMixr::Object*>& Objects()
 		{
 			return m_PluginObjects;
 		}
 
+		/**
+		 * Get an Object by id, O(1).
+		 * @param id id, index into Objects()
+		 * @return object, nullptr when there is no such Object
+		 */
+		SoundMixr::Object* Get(int id)
+		{
+			return id >= 0 && id < static_cast<int>(m_PluginObjects.size()) ? m_PluginObjects[id] : nullptr;
+		}
+
+		/**
+		 * Resolve a handle, O(1).
+		 * @param h handle
+		 * @return object, nullptr when the handle is invalid or of another type
+		 */
+		template<typename T>
+		T* Get(Handle<T> h)
+		{
+			if (h.id < 0 || h.id >= static_cast<int>(m_PluginObjects.size()) || m_Types[h.id] != TypeTag<T>())
+				return nullptr;
+
+			return static_cast<T*>(m_PluginObjects[h.id]);
+		}
+
+		/**
+		 * Get the handle of an Object created by this plugin.
+		 * @param object object
+		 * @return handle
+		 */
+		template<typename T>
+		Handle<T> HandleOf(T& object) { return { object.ObjectId() }; }
+
+		/**
+		 * Find an Object by the name it was created with, using a hash map. Names
+		 * should be unique, when one is used more than once this finds the first.
+		 * @param name name
+		 * @return id, -1 when not found
+		 */
+		int Find(std::string_view name) const
+		{
+			auto i = m_Names.find(Hash(name));
+			if (i == m_Names.end())
+				return -1;
+
+			if (m_ObjectNames[i->second] == name)
+				return i->second;
+
+			// Another name with the same hash, only then search all names
+			for (size_t id = 0; id < m_ObjectNames.size(); id++)
+				if (m_ObjectNames[id] == name)
+					return static_cast<int>(id);
+			return -1;
+		}
+
+		/**
+		 * Find an Object of a type by the name it was created with.
+		 * @param name name
+		 * @return handle, invalid when not found or of another type
+		 */
+		template<typename T>
+		Handle<T> Find(std::string_view name) const
+		{
+			int id = Find(name);
+			return { id >= 0 && m_Types[id] == TypeTag<T>() ? id : -1 };
+		}
+
+		static constexpr int MaxAutomationEvents = 1024;
+
+		/**
+		 * Set the automation of the next block, audio thread. The events are copied into a
+		 * fixed pool and grouped per Parameter, events for other Objects and events beyond
+		 * MaxAutomationEvents are dropped. Doesn't allocate.
+		 * @param events events, sorted by offset
+		 * @param count amount of events
+		 */
+		void Automate(const AutomationEvent* events, int count)
+		{
+			// Counting sort on id keeps the events of each Parameter sorted by offset
+			std::fill(m_AutomationStart.begin(), m_AutomationStart.end(), 0);
+			count = std::min(count, MaxAutomationEvents);
+			m_AutomationCount = 0;
+			for (int e = 0; e < count; e++)
+				if (IsAutomatable(events[e].id))
+					m_AutomationStart[events[e].id + 1]++, m_AutomationCount++;
+
+			for (size_t i = 1; i < m_AutomationStart.size(); i++)
+				m_AutomationStart[i] += m_AutomationStart[i - 1];
+
+			for (int e = 0; e < count; e++)
+				if (IsAutomatable(events[e].id))
+					m_Automation[m_AutomationStart[events[e].id]++] = events[e];
+
+			// Placing moved every start to the next id, shift them back
+			for (size_t i = m_AutomationStart.size() - 1; i > 0; i--)
+				m_AutomationStart[i] = m_AutomationStart[i - 1];
+			m_AutomationStart[0] = 0;
+		}
+
+		/**
+		 * Get the automation events of a Parameter in the current block.
+		 * @param id object id
+		 * @param events receives the events, sorted by offset
+		 * @return amount of events
+		 */
+		int Automation(int id, const AutomationEvent*& events) const
+		{
+			if (!IsAutomatable(id))
+				return 0;
+
+			events = m_Automation.data() + m_AutomationStart[id];
+			return m_AutomationStart[id + 1] - m_AutomationStart[id];
+		}
+
+		/**
+		 * Fill a buffer with the sample accurate value of a Parameter in the current block.
+		 * @param p parameter
+		 * @param out output buffer
+		 * @param frames amount of samples
+		 */
+		void Ramp(SoundMixr::Parameter& p, float* out, int frames)
+		{
+			const AutomationEvent* events = nullptr;
+			int count = Automation(p.ObjectId(), events);
+			p.Ramp(out, frames, events, count);
+		}
+
 	protected:
 		SoundMixr::Div m_Div;
-		std::vector<std::unique_ptr<SoundMixr::Object>> m_PluginObjects;
+		ObjectArena m_Arena;
+		std::vector<SoundMixr::Object*> m_PluginObjects;
+		std::vector<const void*> m_Types; // Type tag per Object
+		std::unordered_map<uint64_t, int> m_Names; // Hashed name to first id with that hash
+		std::vector<std::string> m_ObjectNames; // Name per Object, to verify lookups
+		std::vector<bool> m_Automatable; // Object is a Parameter
+		std::vector<int> m_AutomationStart{ 0, 0 }; // First event per id, sized on Add
+		std::array<AutomationEvent, MaxAutomationEvents> m_Automation;
+		int m_AutomationCount = 0;
+
+		bool IsAutomatable(int id) const { return id >= 0 && id < static_cast<int>(m_Automatable.size()) && m_Automatable[id]; }
+
+		/**
+		 * Apply the automation events at one offset, as used when splitting blocks.
+		 * @param events all events of the block, sorted by offset
+		 * @param count amount of events
+		 * @param e index of the first event at the offset, moved past them
+		 */
+		void ApplyAutomation(const AutomationEvent* events, int count, int& e)
+		{
+			const int offset = events[e].offset;
+			for (; e < count && events[e].offset == offset; e++)
+				if (IsAutomatable(events[e].id))
+					static_cast<SoundMixr::Parameter*>(m_PluginObjects[events[e].id])->Automate(events[e].value);
+		}
+		ChangeQueue m_Changes;
+		std::atomic<bool> m_Resync{ false };
+		std::vector<int> m_Changed;
+		std::atomic<uint64_t> m_Clock{ 0 };
 		const std::string m_Name = "";
 		double m_SampleRate = 48000;
 		Pair<int> m_Size{ 300, 145 };
+
+		/**
+		 * Construct an Object in the arena, give it the next id and attach it to the change queue.
+		 * @param args constructor arguments
+		 * @return the object
+		 */
+		template<typename T, typename ...Args>
+		T& Add(Args&& ...args)
+		{
+			return Register(m_Arena.Create<T>(std::forward<Args>(args)...));
+		}
+
+		/**
+		 * Add an Object allocated elsewhere, the plugin takes ownership.
+		 * @param object object
+		 * @return the object
+		 */
+		template<typename T>
+		T& Add(std::unique_ptr<T> object)
+		{
+			return Register(m_Arena.Adopt(std::move(object)));
+		}
+
+		/**
+		 * Make an Object findable by name, names should be unique. Objects without
+		 * a name aren't findable.
+		 * @param object object
+		 * @param name name
+		 * @return the object
+		 */
+		template<typename T>
+		T& Named(T& object, std::string_view name)
+		{
+			if (name.empty())
+				return object;
+
+			assert(Find(name) == -1 && "Object name is already used");
+			m_ObjectNames[object.ObjectId()] = name;
+			m_Names.emplace(Hash(name), object.ObjectId());
+			return object;
+		}
+
+	private:
+		template<typename T>
+		T& Register(T* object)
+		{
+			object->Attach(&m_Changes, static_cast<int>(m_PluginObjects.size()), &m_Clock, &m_Resync);
+			m_PluginObjects.push_back(object);
+			m_Changed.reserve(m_PluginObjects.capacity()); // A resync returns every id
+			m_Types.push_back(TypeTag<T>());
+			m_ObjectNames.emplace_back();
+			m_Automatable.push_back(std::is_base_of_v<SoundMixr::Parameter, T>);
+			m_AutomationStart.resize(m_PluginObjects.size() + 1);
+			return *object;
+		}
+
+		// Unique address per type, identifies the exact type of an Object
+		template<typename T>
+		static const void* TypeTag()
+		{
+			static const char tag = 0;
+			return &tag;
+		}
+
+		// 64 bit FNV-1a
+		static uint64_t Hash(std::string_view name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (char c : name)
+				hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+			return hash;
+		}
+	};
+
+	/**
+	 * Morphs between snapshots of the Parameters, DropDowns and ToggleButtons of a plugin.
+	 * Snapshots are captured on the UI thread into flat preallocated arrays of normalized
+	 * values, Morph is called by the audio thread once per block and doesn't allocate or
+	 * touch json. Parameters are interpolated, and smoothed by the Parameter itself like
+	 * any other change; discrete objects take the value of the snapshot with the largest
+	 * weight, so between two snapshots they switch at t = 0.5.
+	 *
+	 * Morphed values don't go through the change queue or advance the generation, they're
+	 * the live state of the plugin, not a saved change.
+	 */
+	class PresetMorph
+	{
+	public:
+
+		/**
+		 * Constructor, takes the Objects the plugin has at this point.
+		 * @param plugin plugin
+		 * @param snapshots maximum amount of snapshots
+		 */
+		PresetMorph(PluginBase& plugin, int snapshots = 4)
+			: m_Snapshots(std::max(snapshots, 1))
+		{
+			for (Object* o : plugin.Objects())
+			{
+				if (dynamic_cast<Parameter*>(o))
+					m_Slots.push_back({ o, Slot::Continuous });
+				else if (dynamic_cast<SoundMixr::DropDown*>(o))
+					m_Slots.push_back({ o, Slot::Selection });
+				else if (dynamic_cast<ToggleButton*>(o))
+					m_Slots.push_back({ o, Slot::Toggle });
+			}
+
+			m_Values = std::make_unique<std::atomic<double>[]>(m_Snapshots * m_Slots.size());
+			m_Index.resize(m_Snapshots);
+			m_Weights.resize(m_Snapshots);
+			Capture(0);
+			for (int s = 1; s < m_Snapshots; s++)
+				Copy(0, s);
+		}
+
+		/**
+		 * @return maximum amount of snapshots
+		 */
+		int Snapshots() const { return m_Snapshots; }
+
+		/**
+		 * Keep an Object out of the morph, like the parameters that drive it.
+		 * Call before morphing.
+		 * @param o object
+		 */
+		void Exclude(Object& o)
+		{
+			for (auto& slot : m_Slots)
+				if (slot.object == &o)
+					slot.excluded = true;
+		}
+
+		/**
+		 * Capture the current state into a snapshot, UI thread.
+		 * @param s snapshot
+		 */
+		void Capture(int s)
+		{
+			if (s < 0 || s >= m_Snapshots)
+				return;
+
+			std::atomic<double>* values = &m_Values[s * m_Slots.size()];
+			for (size_t i = 0; i < m_Slots.size(); i++)
+				values[i].store(Read(m_Slots[i]), std::memory_order_relaxed);
+		}
+
+		/**
+		 * Copy a snapshot to another snapshot, UI thread.
+		 * @param from snapshot
+		 * @param to snapshot
+		 */
+		void Copy(int from, int to)
+		{
+			if (from < 0 || from >= m_Snapshots || to < 0 || to >= m_Snapshots)
+				return;
+
+			for (size_t i = 0; i < m_Slots.size(); i++)
+				m_Values[to * m_Slots.size() + i].store(m_Values[from * m_Slots.size() + i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		/**
+		 * Morph between 2 snapshots, audio thread.
+		 * @param a snapshot at t = 0
+		 * @param b snapshot at t = 1
+		 * @param t position
+		 * @return true when any value changed
+		 */
+		bool Morph(int a, int b, double t)
+		{
+			t = constrain(t, 0.0, 1.0);
+			m_Index[0] = a, m_Weights[0] = 1 - t;
+			m_Index[1] = b, m_Weights[1] = t;
+			return Blend(2);
+		}
+
+		/**
+		 * Morph between 4 snapshots in the corners of a square, audio thread.
+		 * @param a snapshot at (0, 0)
+		 * @param b snapshot at (1, 0)
+		 * @param c snapshot at (0, 1)
+		 * @param d snapshot at (1, 1)
+		 * @param x position on the x-axis
+		 * @param y position on the y-axis
+		 * @return true when any value changed
+		 */
+		bool Morph(int a, int b, int c, int d, double x, double y)
+		{
+			if (m_Snapshots < 4)
+				return false;
+
+			x = constrain(x, 0.0, 1.0), y = constrain(y, 0.0, 1.0);
+			m_Index[0] = a, m_Weights[0] = (1 - x) * (1 - y);
+			m_Index[1] = b, m_Weights[1] = x * (1 - y);
+			m_Index[2] = c, m_Weights[2] = (1 - x) * y;
+			m_Index[3] = d, m_Weights[3] = x * y;
+			return Blend(4);
+		}
+
+		/**
+		 * Morph between 4 snapshots driven by an XYController, audio thread. The
+		 * parameters of the controller should be excluded from the morph.
+		 * @param xy controller
+		 * @param a snapshot at (0, 0)
+		 * @param b snapshot at (1, 0)
+		 * @param c snapshot at (0, 1)
+		 * @param d snapshot at (1, 1)
+		 * @return true when any value changed
+		 */
+		bool Morph(XYController& xy, int a, int b, int c, int d)
+		{
+			return Morph(a, b, c, d, xy.Param1().NormalizedValue(), xy.Param2().NormalizedValue());
+		}
+
+		/**
+		 * Morph between all snapshots, audio thread.
+		 * @param weights a weight per snapshot, normalized by their sum
+		 * @return true when any value changed
+		 */
+		bool Morph(const double* weights)
+		{
+			for (int s = 0; s < m_Snapshots; s++)
+				m_Index[s] = s, m_Weights[s] = std::max(weights[s], 0.0);
+			return Blend(m_Snapshots);
+		}
+
+	private:
+		struct Slot
+		{
+			enum Kind { Continuous, Selection, Toggle };
+
+			Object* object;
+			Kind kind;
+			bool excluded = false;
+		};
+
+		int m_Snapshots;
+		std::vector<Slot> m_Slots;
+		std::unique_ptr<std::atomic<double>[]> m_Values; // [snapshot][slot]
+		std::vector<int> m_Index;
+		std::vector<double> m_Weights;
+
+		static double Read(const Slot& slot)
+		{
+			switch (slot.kind)
+			{
+			case Slot::Continuous: return static_cast<Parameter*>(slot.object)->m_Value.load();
+			case Slot::Selection: return static_cast<SoundMixr::DropDown*>(slot.object)->m_Selected.load();
+			default: return static_cast<ToggleButton*>(slot.object)->state.load();
+			}
+		}
+
+		bool Blend(int n)
+		{
+			// Normalize the weights and find the snapshot the discrete objects switch to
+			double sum = 0;
+			int nearest = 0;
+			for (int k = 0; k < n; k++)
+			{
+				m_Index[k] = constrain(m_Index[k], 0, m_Snapshots - 1);
+				sum += m_Weights[k];
+				if (m_Weights[k] > m_Weights[nearest])
+					nearest = k;
+			}
+			if (sum <= 0)
+				return false;
+
+			bool changed = false;
+			const size_t slots = m_Slots.size();
+			for (size_t i = 0; i < slots; i++)
+			{
+				const Slot& slot = m_Slots[i];
+				if (slot.excluded)
+					continue;
+
+				double value;
+				if (slot.kind == Slot::Continuous)
+				{
+					value = 0;
+					for (int k = 0; k < n; k++)
+						value += m_Weights[k] * m_Values[m_Index[k] * slots + i].load(std::memory_order_relaxed);
+					value /= sum;
+				}
+				else
+					value = m_Values[m_Index[nearest] * slots + i].load(std::memory_order_relaxed);
+
+				if (value == Read(slot))
+					continue;
+
+				changed = true;
+				switch (slot.kind)
+				{
+				case Slot::Continuous: static_cast<Parameter*>(slot.object)->m_Value.store(value); break;
+				case Slot::Selection: static_cast<SoundMixr::DropDown*>(slot.object)->m_Selected.store((int)value); break;
+				default: static_cast<ToggleButton*>(slot.object)->state.store(value != 0);
+				}
+			}
+			return changed;
+		}
 	};
 
 	class EffectBase : public PluginBase
@@ -1309,6 +2913,69 @@ namespace SoundMixr
 		 * @return next sample
 		 */
 		virtual float Process(float in, int c) = 0;
+
+		/**
+		 * Process a block of samples for all channels. The default implementation calls
+		 * Process for every sample, in the same interleaved channel order a host uses
+		 * when calling Process directly. Override this to process whole blocks at once.
+		 * @param in input buffers, one per channel
+		 * @param out output buffers, one per channel, may be the same as in
+		 * @param channels amount of channels
+		 * @param frames amount of samples per channel
+		 */
+		virtual void ProcessBlock(const float* const* in, float* const* out, int channels, int frames)
+		{
+			for (int i = 0; i < frames; i++)
+				for (int c = 0; c < channels; c++)
+					out[c][i] = Process(in[c][i], c);
+		}
+
+		static constexpr int MaxChannels = 64;
+
+		/**
+		 * Process a block with sample accurate automation. The events are made available
+		 * through Automation and Ramp, then the block is split at the event offsets and
+		 * each part is processed by ProcessBlock after the events at its start are applied.
+		 * Plugins that use Ramp can override this to process the whole block at once.
+		 * With more than MaxChannels channels the block isn't split.
+		 * @param in input buffers, one per channel
+		 * @param out output buffers, one per channel, may be the same as in
+		 * @param channels amount of channels
+		 * @param frames amount of samples per channel
+		 * @param events automation events, sorted by offset
+		 * @param count amount of automation events
+		 */
+		virtual void ProcessBlock(const float* const* in, float* const* out, int channels, int frames, const AutomationEvent* events, int count)
+		{
+			Automate(events, count);
+			if (channels > MaxChannels)
+			{
+				for (int e = 0; e < count;)
+					ApplyAutomation(events, count, e);
+				return ProcessBlock(in, out, channels, frames);
+			}
+
+			const float* partIn[MaxChannels];
+			float* partOut[MaxChannels];
+			int start = 0;
+			for (int e = 0; e <= count;)
+			{
+				int end = e < count ? constrain(events[e].offset, start, frames) : frames;
+				if (end > start)
+				{
+					for (int c = 0; c < channels; c++)
+						partIn[c] = in[c] + start, partOut[c] = out[c] + start;
+					ProcessBlock(partIn, partOut, channels, end - start);
+				}
+
+				if (e < count)
+					ApplyAutomation(events, count, e);
+				else
+					e++;
+
+				start = end;
+			}
+		}
 	};
 
 	class MidiData
@@ -1356,6 +3023,15 @@ namespace SoundMixr
 		};
 	};
 
+	/**
+	 * Midi data with the sample offset inside the current block at which it occurs.
+	 */
+	struct MidiEvent
+	{
+		int offset;
+		MidiData data;
+	};
+
 	class GeneratorBase : public PluginBase
 	{
 	public:
@@ -1373,12 +3049,78 @@ namespace SoundMixr
 
 		// TODO: implement a proper way of receiving all sorts of midi data.
 		virtual void ReceiveMidi(MidiData data) {};
+
+		/**
+		 * Generate a block of samples for all channels. The block is split at the offsets
+		 * of the midi events, each event is passed to ReceiveMidi right before the sample
+		 * it occurs on, and the parts in between are rendered using Render.
+		 * @param out output buffers, one per channel
+		 * @param channels amount of channels
+		 * @param frames amount of samples per channel
+		 * @param events midi events, sorted by offset
+		 * @param count amount of midi events
+		 */
+		virtual void GenerateBlock(float* const* out, int channels, int frames, const MidiEvent* events, int count)
+		{
+			GenerateBlock(out, channels, frames, events, count, nullptr, 0);
+		}
+
+		/**
+		 * Generate a block with sample accurate automation. The automation events are made
+		 * available through Automation and Ramp, and the block is split at the offsets of both
+		 * the midi and the automation events. Automation at the same offset as a midi event
+		 * is applied first.
+		 * @param out output buffers, one per channel
+		 * @param channels amount of channels
+		 * @param frames amount of samples per channel
+		 * @param events midi events, sorted by offset
+		 * @param count amount of midi events
+		 * @param automation automation events, sorted by offset
+		 * @param automationCount amount of automation events
+		 */
+		virtual void GenerateBlock(float* const* out, int channels, int frames, const MidiEvent* events, int count,
+			const AutomationEvent* automation, int automationCount)
+		{
+			Automate(automation, automationCount);
+			int start = 0, e = 0, a = 0;
+			while (true)
+			{
+				int midi = e < count ? constrain(events[e].offset, start, frames) : frames;
+				int automated = a < automationCount ? constrain(automation[a].offset, start, frames) : frames;
+				int end = std::min(midi, automated);
+				if (end > start)
+					Render(out, channels, start, end - start);
+
+				start = end;
+				if (a < automationCount && automated == end)
+					ApplyAutomation(automation, automationCount, a);
+				else if (e < count && midi == end)
+					ReceiveMidi(events[e++].data);
+				else
+					break;
+			}
+		}
+
+		/**
+		 * Render a part of a block without any midi events in it. The default implementation
+		 * calls Generate for every sample, override this to render whole sub-blocks at once.
+		 * @param out output buffers, one per channel
+		 * @param channels amount of channels
+		 * @param offset offset of the first sample to render in the output buffers
+		 * @param frames amount of samples to render
+		 */
+		virtual void Render(float* const* out, int channels, int offset, int frames)
+		{
+			for (int i = offset; i < offset + frames; i++)
+				for (int c = 0; c < channels; c++)
+					out[c][i] = Generate(c);
+		}
 	};
 }
 
 extern "C" DLLDIR int __cdecl Version()
 {
-	return 13;
+	return 14;
 }
 
 #define EFFECT 1
@@ -1,16 +1,137 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Filters.hpp"
 
 
 #define db2lin(db) std::powf(10.0f, 0.05 * (db))
 #define lin2db(lin) (20.0f * std::log10f(static_cast<float>(lin)))
 #define myabs(f) if (f < 0) f = -f;
 
+/**
+ * log2 of a positive normal float without a library call, so loops over it vectorize.
+ * Splits off the exponent and uses the atanh series for the mantissa, within 2e-5.
+ */
+inline float FastLog2(float x)
+{
+	uint32_t i;
+	std::memcpy(&i, &x, 4);
+	const float e = (float)((int)(i >> 23) - 127);
+	i = (i & 0x007FFFFF) | 0x3F800000;
+	float m;
+	std::memcpy(&m, &i, 4);
+
+	// ln(m) = 2 atanh(z), z = (m - 1) / (m + 1) is at most 1/3
+	const float z = (m - 1) / (m + 1), z2 = z * z;
+	const float ln = 2 * z * (1 + z2 * (1 / 3.0f + z2 * (1 / 5.0f + z2 * (1 / 7.0f + z2 / 9.0f))));
+	return e + ln * 1.44269504f;
+}
+
+/**
+ * exp2 without a library call, so loops over it vectorize. Relative error below 3e-7,
+ * results below 2^-125 are 0 so they are never denormal.
+ */
+inline float FastExp2(float x)
+{
+	// Adding 1.5 * 2^23 rounds to the nearest integer, which ends up in the low bits of the mantissa
+	constexpr float magic = 12582912.0f;
+	const float r = x + magic;
+	int32_t n;
+	std::memcpy(&n, &r, 4);
+	n = std::min(std::max(n - 0x4B400000, -126), 127);
+	const float f = (x - (r - magic)) * 0.693147181f;
+
+	// Taylor series of e^f for f in [-ln 2 / 2, ln 2 / 2]
+	const float p = 1 + f * (1 + f * (1 / 2.0f + f * (1 / 6.0f + f * (1 / 24.0f + f * (1 / 120.0f + f / 720.0f)))));
+	const uint32_t i = n < -125 ? 0 : (uint32_t)(n + 127) << 23;
+	float scale;
+	std::memcpy(&scale, &i, 4);
+	return p * scale;
+}
+
+/**
+ * Maximum of the last Size() values in amortized constant time, using a monotonic
+ * deque in a preallocated ring. Values that can never become the maximum again are
+ * dropped, so the deque is decreasing from front to back.
+ */
+class SlidingMaximum
+{
+public:
+	/**
+	 * Set the window size, allocates and resets.
+	 * @param n window size in samples
+	 */
+	void Size(int n)
+	{
+		m_Size = std::max(n, 1);
+		m_Values.assign(m_Size, 0);
+		m_Times.assign(m_Size, 0);
+		Reset();
+	}
+
+	/**
+	 * Get the window size.
+	 * @return window size in samples
+	 */
+	int Size() const { return m_Size; }
+
+	void Reset()
+	{
+		m_Front = 0, m_Count = 0, m_Time = 0;
+	}
+
+	/**
+	 * Add a value.
+	 * @param x value
+	 * @return maximum of the last Size() values
+	 */
+	float Process(float x)
+	{
+		// Remove smaller values from the back
+		while (m_Count > 0 && m_Values[Index(m_Count - 1)] <= x)
+			m_Count--;
+
+		// Remove the front when it left the window
+		if (m_Count > 0 && m_Time - m_Times[m_Front] >= (uint32_t)m_Size)
+			m_Front = Index(1), m_Count--;
+
+		const int back = Index(m_Count);
+		m_Values[back] = x;
+		m_Times[back] = m_Time++;
+		m_Count++;
+		return m_Values[m_Front];
+	}
+
+private:
+	int m_Size = 0;
+	int m_Front = 0;
+	int m_Count = 0;
+	uint32_t m_Time = 0;
+	std::vector<float> m_Values;
+	std::vector<uint32_t> m_Times;
+
+	int Index(int i) const { return m_Front + i >= m_Size ? m_Front + i - m_Size : m_Front + i; }
+};
 
 class Compressor
 {
 public:
+	/**
+	 * How the channels are detected in block processing.
+	 */
+	enum Linking
+	{
+		Independent, // Every channel has its own detector
+		Max,         // One detector on the loudest channel
+		Average,     // One detector on the average of the channel peaks
+		Grouped      // One detector per group, on the loudest channel in the group
+	};
+
 	double sampleRate = 48000;
 	static inline const double DC_OFFSET = 1.0E-25;
 
@@ -37,6 +158,9 @@ public:
 
 	int zerocounter = 0;
 
+	int controlRate = 16; // Samples per detector update in block processing
+	Linking linking = Max;
+
 	void Attack(float ms)
 	{
 		double newval = ms;
@@ -80,69 +204,943 @@ public:
 		}
 		else
 		{
-			float s = biggest;
+			Detect(biggest, attcoef, relcoef);
 			biggest = 0;
-			s *= pregain;
-			float _absSample = s;
-			myabs(_absSample);
-
-			// convert key to dB
-			_absSample += DC_OFFSET;	// add DC offset to avoid log( 0 )
-			float _absSampledB = lin2db(_absSample); // convert linear -> dB
-
-			// threshold
-			float _overdB = _absSampledB - expanderThreshhold;
-			if (_overdB > 0.0)
-				_overdB = 0.0;
-
-			// attack/release
-			_overdB += DC_OFFSET; // add DC offset to avoid denormal	
-			if (_overdB > expanderEnv)
-				expanderEnv = _overdB + attcoef * (expanderEnv - _overdB);
-			else
-				expanderEnv = _overdB + relcoef * (expanderEnv - _overdB);
+			out = sin * pregain * compressMult * expanderMult * postgain;
+		}
+
+		return out;
+	}
 
-			_overdB = expanderEnv - DC_OFFSET; // subtract DC offset
+	/**
+	 * Set the amount of channels for block processing, allocates the detector state
+	 * and puts all channels in group 0. Not realtime safe, call it before processing.
+	 * @param channels amount of channels
+	 */
+	void Channels(int channels)
+	{
+		m_Channels = channels;
+		m_Group.assign(channels, 0);
+		m_Peak.assign(channels, 0);
+		m_Level.assign(channels, 0);
+		m_Gain.assign(channels, 1);
+		m_Target.assign(channels, 1);
+		m_ExpanderEnv.assign(channels, DC_OFFSET);
+		m_CompressEnv.assign(channels, DC_OFFSET);
+		m_ExpanderMult.assign(channels, 1);
+		m_CompressMult.assign(channels, 1);
+		Allocate();
+	}
 
-				// transfer function
-			float _gr = _overdB * (expanderRatio - 1.0) * mix;
-			expanderMult = db2lin(_gr); // convert dB -> linear
+	/**
+	 * Clear the detectors and lookahead of the block processing, the gain starts at unity again.
+	 */
+	void Reset()
+	{
+		std::fill(m_Gain.begin(), m_Gain.end(), 1.0f);
+		std::fill(m_Target.begin(), m_Target.end(), 1.0f);
+		std::fill(m_ExpanderEnv.begin(), m_ExpanderEnv.end(), DC_OFFSET);
+		std::fill(m_CompressEnv.begin(), m_CompressEnv.end(), DC_OFFSET);
+		std::fill(m_ExpanderMult.begin(), m_ExpanderMult.end(), 1.0);
+		std::fill(m_CompressMult.begin(), m_CompressMult.end(), 1.0);
+		zerocounter = 0;
+		Allocate();
+	}
 
-			// output gain expander
-			s *= expanderMult;
+	/**
+	 * Set the lookahead, delays the audio so the detector sees peaks before they
+	 * are processed. Allocates the delay lines.
+	 * @param ms lookahead in milliseconds
+	 */
+	void Lookahead(double ms)
+	{
+		int samples = (int)std::round(std::max(ms, 0.0) / 1000.0 * sampleRate);
+		if (samples == m_Lookahead)
+			return;
 
-			// Absolute of new sample
-			_absSample = s;
-			myabs(_absSample);
+		m_Lookahead = samples;
+		Allocate();
+	}
 
-			// convert key to dB
-			_absSample += DC_OFFSET;	// add DC offset to avoid log( 0 )
-			_absSampledB = lin2db(_absSample); // convert linear -> dB
+	/**
+	 * Get the lookahead.
+	 * @return lookahead in milliseconds
+	 */
+	double Lookahead() const { return m_Lookahead * 1000.0 / sampleRate; }
 
-			// threshold
-			_overdB = _absSampledB - compressThreshhold;
-			if (_overdB < 0.0)
-				_overdB = 0.0;
+	/**
+	 * Latency of the block processing caused by the lookahead.
+	 * @return latency in samples
+	 */
+	int Latency() const { return m_Lookahead; }
 
-			// attack/release
-			_overdB += DC_OFFSET; // add DC offset to avoid denormal	
-			if (_overdB > compressEnv)
-				compressEnv = _overdB + attcoef * (compressEnv - _overdB);
-			else
-				compressEnv = _overdB + relcoef * (compressEnv - _overdB);
-			_overdB = compressEnv - DC_OFFSET;// subtract DC offset
+	/**
+	 * Get the amount of channels for block processing.
+	 * @return channels
+	 */
+	int Channels() const { return m_Channels; }
 
-			// transfer function
-			_gr = _overdB * (compressRatio - 1.0) * mix;
-			compressMult = db2lin(_gr); // convert dB -> linear
+	/**
+	 * Set the group of a channel, used when linking is Grouped.
+	 * @param channel channel
+	 * @param group group, 0 to Channels() - 1
+	 */
+	void Group(int channel, int group) { m_Group[channel] = std::clamp(group, 0, m_Channels - 1); }
 
-			// output gain
-			s;
-			out = sin * pregain * compressMult * expanderMult * postgain;
+	/**
+	 * Get the gain reduction of a channel from the last block processing.
+	 * @param channel channel
+	 * @return expander and compressor gain multiplier
+	 */
+	double GainReduction(int channel) const
+	{
+		int d = Detector(channel);
+		return m_ExpanderMult[d] * m_CompressMult[d];
+	}
+
+	/**
+	 * Process a block of audio. The detectors run once every controlRate samples on the
+	 * peaks in that part, linked as set by linking, the gain is linearly interpolated
+	 * in between. With lookahead the peaks are taken over the lookahead window and the
+	 * audio is delayed by Latency(). At most Channels() channels are processed, the
+	 * rest of the output is left untouched.
+	 * @param in input channels
+	 * @param out output channels, may be the same as in
+	 * @param channels amount of channels
+	 * @param frames amount of samples per channel
+	 */
+	void Process(const float* const* in, float* const* out, int channels, int frames)
+	{
+		assert(channels <= m_Channels);
+		channels = std::min(channels, m_Channels);
+		if (channels <= 0)
+			return;
+
+		const int k = std::max(controlRate, 1);
+		const double att = std::pow(attcoef, k), rel = std::pow(relcoef, k);
+		for (int i = 0; i < frames; i += k)
+		{
+			const int n = std::min(k, frames - i);
+
+			float loudest = 0;
+			for (int c = 0; c < channels; c++)
+			{
+				const float* x = in[c] + i;
+				float peak = 0;
+				if (m_Lookahead == 0)
+					for (int j = 0; j < n; j++)
+						peak = std::max(peak, std::abs(x[j]));
+				else
+					for (int j = 0; j < n; j++)
+						peak = std::max(peak, m_Window[c].Process(std::abs(x[j])));
+				m_Peak[c] = peak;
+				loudest = std::max(loudest, peak);
+			}
+
+			zerocounter = loudest == 0 ? std::min(zerocounter + n, 101) : 0;
+			if (zerocounter <= 100)
+			{
+				const int detectors = Link(channels);
+				const double a = n == k ? att : std::pow(attcoef, n);
+				const double r = n == k ? rel : std::pow(relcoef, n);
+				for (int d = 0; d < detectors; d++)
+				{
+					Detect(m_Level[d], a, r, m_ExpanderEnv[d], m_CompressEnv[d], m_ExpanderMult[d], m_CompressMult[d]);
+					m_Target[d] = pregain * m_ExpanderMult[d] * m_CompressMult[d] * postgain;
+				}
+			}
+
+			for (int c = 0; c < channels; c++)
+			{
+				const float* x = in[c] + i;
+				float* y = out[c] + i;
+				const float g = m_Gain[c];
+				const float target = zerocounter > 100 ? 0 : m_Target[Detector(c)];
+				const float step = (target - g) / n;
+				if (m_Lookahead == 0)
+					for (int j = 0; j < n; j++)
+						y[j] = x[j] * (g + step * (j + 1));
+				else
+				{
+					float* delay = &m_Delay[c * m_Lookahead];
+					int pos = m_DelayPos[c];
+					for (int j = 0; j < n; j++)
+					{
+						const float d = delay[pos];
+						delay[pos] = x[j];
+						y[j] = d * (g + step * (j + 1));
+						pos = pos + 1 == m_Lookahead ? 0 : pos + 1;
+					}
+					m_DelayPos[c] = pos;
+				}
+				m_Gain[c] = target;
+			}
 		}
+	}
 
-		return out;
+	/**
+	 * Update the expander and compressor envelopes and gains.
+	 * @param peak absolute peak since the last update
+	 * @param att attack coefficient
+	 * @param rel release coefficient
+	 */
+	void Detect(float peak, double att, double rel)
+	{
+		Detect(peak, att, rel, expanderEnv, compressEnv, expanderMult, compressMult);
+	}
+
+	/**
+	 * Update an expander and compressor envelope and gain.
+	 * @param peak absolute peak since the last update
+	 * @param att attack coefficient
+	 * @param rel release coefficient
+	 * @param expanderEnv expander envelope
+	 * @param compressEnv compressor envelope
+	 * @param expanderMult resulting expander gain
+	 * @param compressMult resulting compressor gain
+	 */
+	void Detect(float peak, double att, double rel, double& expanderEnv, double& compressEnv, double& expanderMult, double& compressMult)
+	{
+		float s = peak * pregain;
+		float _absSample = s;
+		myabs(_absSample);
+
+		// convert key to dB
+		_absSample += DC_OFFSET;	// add DC offset to avoid log( 0 )
+		float _absSampledB = lin2db(_absSample); // convert linear -> dB
+
+		// threshold
+		float _overdB = _absSampledB - expanderThreshhold;
+		if (_overdB > 0.0)
+			_overdB = 0.0;
+
+		// attack/release
+		_overdB += DC_OFFSET; // add DC offset to avoid denormal	
+		if (_overdB > expanderEnv)
+			expanderEnv = _overdB + att * (expanderEnv - _overdB);
+		else
+			expanderEnv = _overdB + rel * (expanderEnv - _overdB);
+
+		_overdB = expanderEnv - DC_OFFSET; // subtract DC offset
+
+			// transfer function
+		float _gr = _overdB * (expanderRatio - 1.0) * mix;
+		expanderMult = db2lin(_gr); // convert dB -> linear
+
+		// output gain expander
+		s *= expanderMult;
+
+		// Absolute of new sample
+		_absSample = s;
+		myabs(_absSample);
+
+		// convert key to dB
+		_absSample += DC_OFFSET;	// add DC offset to avoid log( 0 )
+		_absSampledB = lin2db(_absSample); // convert linear -> dB
+
+		// threshold
+		_overdB = _absSampledB - compressThreshhold;
+		if (_overdB < 0.0)
+			_overdB = 0.0;
+
+		// attack/release
+		_overdB += DC_OFFSET; // add DC offset to avoid denormal	
+		if (_overdB > compressEnv)
+			compressEnv = _overdB + att * (compressEnv - _overdB);
+		else
+			compressEnv = _overdB + rel * (compressEnv - _overdB);
+		_overdB = compressEnv - DC_OFFSET;// subtract DC offset
+
+		// transfer function
+		_gr = _overdB * (compressRatio - 1.0) * mix;
+		compressMult = db2lin(_gr); // convert dB -> linear
 	}
 
 	float Coeficient(float ms) { return std::exp(-1.0 / ((ms / 1000.0) * sampleRate)); }
-};
\ No newline at end of file
+
+private:
+	int m_Channels = 0;
+	int m_Lookahead = 0;
+
+	// Lookahead delay lines, Lookahead samples per channel
+	std::vector<float> m_Delay;
+	std::vector<int> m_DelayPos;
+	std::vector<SlidingMaximum> m_Window;
+
+	// Per channel
+	std::vector<int> m_Group;
+	std::vector<float> m_Peak;
+	std::vector<float> m_Gain;
+
+	// Per detector, indexed by channel when independent, by group when grouped
+	std::vector<float> m_Level;
+	std::vector<float> m_Target;
+	std::vector<double> m_ExpanderEnv;
+	std::vector<double> m_CompressEnv;
+	std::vector<double> m_ExpanderMult;
+	std::vector<double> m_CompressMult;
+
+	void Allocate()
+	{
+		m_Delay.assign(m_Channels * m_Lookahead, 0);
+		m_DelayPos.assign(m_Channels, 0);
+		m_Window.resize(m_Channels);
+		for (auto& w : m_Window)
+			w.Size(m_Lookahead + 1);
+	}
+
+	int Detector(int channel) const
+	{
+		return linking == Independent ? channel : linking == Grouped ? m_Group[channel] : 0;
+	}
+
+	/**
+	 * Combine the channel peaks into the detector levels.
+	 * @return amount of detectors
+	 */
+	int Link(int channels)
+	{
+		switch (linking)
+		{
+		case Independent:
+			std::copy(m_Peak.begin(), m_Peak.begin() + channels, m_Level.begin());
+			return channels;
+		case Max:
+		{
+			float peak = 0;
+			for (int c = 0; c < channels; c++)
+				peak = std::max(peak, m_Peak[c]);
+			m_Level[0] = peak;
+			return 1;
+		}
+		case Average:
+		{
+			float sum = 0;
+			for (int c = 0; c < channels; c++)
+				sum += m_Peak[c];
+			m_Level[0] = channels > 0 ? sum / channels : 0;
+			return 1;
+		}
+		case Grouped:
+		{
+			int groups = 0;
+			std::fill(m_Level.begin(), m_Level.begin() + channels, 0.0f);
+			for (int c = 0; c < channels; c++)
+			{
+				const int g = m_Group[c];
+				m_Level[g] = std::max(m_Level[g], m_Peak[c]);
+				groups = std::max(groups, g + 1);
+			}
+			return groups;
+		}
+		}
+		return 0;
+	}
+};
+
+/**
+ * Compressor that splits the signal in 2 to 5 bands with Linkwitz-Riley (LR4) crossovers,
+ * compresses every band with the settings of its own Compressor and sums them again.
+ * Band b is highpassed by the crossovers below it, lowpassed by crossover b and allpassed
+ * by the crossovers above it so all bands sum back flat. Every band is a lane, so the
+ * crossovers, the detectors and the gain stage run for all bands at once, and the
+ * crossovers of 2 channels run in the same loop so their recursions overlap. The detectors
+ * run once every controlRate samples and are linked over the channels as set by linking.
+ */
+class MultibandCompressor
+{
+public:
+	static constexpr int MaxBands = 5;
+	static constexpr size_t Width = SIMD_BYTES / sizeof(float);
+	static constexpr size_t Lanes = (MaxBands + Width - 1) / Width * Width; // Vectors to fit MaxBands
+	static constexpr int BlockSize = 64;
+
+	/**
+	 * Band settings, only the parameters are used, not the block processing.
+	 */
+	Compressor bands[MaxBands];
+
+	int controlRate = 16; // Samples per detector update
+	Compressor::Linking linking = Compressor::Max;
+
+	MultibandCompressor() { RecalculateParameters(); }
+
+	/**
+	 * Set the amount of bands.
+	 * @param n bands, 2 to MaxBands
+	 */
+	void Bands(int n) { m_Bands = std::clamp(n, 2, MaxBands); RecalculateParameters(); }
+
+	/**
+	 * Get the amount of bands.
+	 * @return bands
+	 */
+	int Bands() const { return m_Bands; }
+
+	/**
+	 * Set a crossover frequency, frequencies should be increasing.
+	 * @param i crossover, 0 to Bands() - 2
+	 * @param f frequency in Hz
+	 */
+	void Crossover(int i, double f)
+	{
+		if (m_Crossover[i] == f)
+			return;
+
+		m_Crossover[i] = f;
+		RecalculateParameters();
+	}
+
+	/**
+	 * Get a crossover frequency.
+	 * @param i crossover
+	 * @return frequency in Hz
+	 */
+	double Crossover(int i) const { return m_Crossover[i]; }
+
+	/**
+	 * Set the samplerate of the crossovers and all band compressors.
+	 * @param s samplerate
+	 */
+	void SampleRate(double s)
+	{
+		m_SampleRate = s;
+		for (auto& b : bands)
+		{
+			b.sampleRate = s;
+			b.attcoef = b.Coeficient(b.attms);
+			b.relcoef = b.Coeficient(b.relms);
+		}
+		RecalculateParameters();
+	}
+
+	/**
+	 * Set the amount of channels, allocates all state and puts all channels in group 0.
+	 * Not realtime safe, call it before processing.
+	 * @param c channels
+	 */
+	void Channels(int c)
+	{
+		m_Channels = c;
+		m_State.assign(c, {});
+		m_Split.assign(c * BlockSize, {});
+		m_Peak.assign(c, {});
+		m_Level.assign(c, {});
+		m_Gain.assign(c, Unity());
+		m_Target.assign(c, Unity());
+		m_Detectors.assign(c, {});
+		m_Group.assign(c, 0);
+		Allocate();
+	}
+
+	/**
+	 * Get the amount of channels.
+	 * @return channels
+	 */
+	int Channels() const { return m_Channels; }
+
+	/**
+	 * Set the lookahead of all bands, delays the audio so the detectors see peaks before
+	 * they are processed. Allocates the delay lines.
+	 * @param ms lookahead in milliseconds
+	 */
+	void Lookahead(double ms)
+	{
+		int samples = (int)std::round(std::max(ms, 0.0) / 1000.0 * m_SampleRate);
+		if (samples == m_Lookahead)
+			return;
+
+		m_Lookahead = samples;
+		Allocate();
+	}
+
+	/**
+	 * Get the lookahead.
+	 * @return lookahead in milliseconds
+	 */
+	double Lookahead() const { return m_Lookahead * 1000.0 / m_SampleRate; }
+
+	/**
+	 * Latency caused by the lookahead.
+	 * @return latency in samples
+	 */
+	int Latency() const { return m_Lookahead; }
+
+	/**
+	 * Set the group of a channel, used when linking is Grouped.
+	 * @param channel channel
+	 * @param group group, 0 to Channels() - 1
+	 */
+	void Group(int channel, int group) { m_Group[channel] = std::clamp(group, 0, m_Channels - 1); }
+
+	/**
+	 * Get the gain reduction of a band on a channel from the last processed block.
+	 * @param band band
+	 * @param channel channel
+	 * @return expander and compressor gain multiplier
+	 */
+	double GainReduction(int band, int channel = 0) const
+	{
+		const Detector& d = m_Detectors[DetectorOf(channel)];
+		return d.expanderMult[band] * d.compressMult[band];
+	}
+
+	/**
+	 * Clear the crossover filters, detectors and lookahead, the gain starts at unity again.
+	 */
+	void Reset()
+	{
+		std::fill(m_State.begin(), m_State.end(), std::array<State, Stages>{});
+		std::fill(m_Gain.begin(), m_Gain.end(), Unity());
+		std::fill(m_Target.begin(), m_Target.end(), Unity());
+		std::fill(m_Detectors.begin(), m_Detectors.end(), Detector{});
+		std::fill(std::begin(m_ZeroCounter), std::end(m_ZeroCounter), 0);
+		Allocate();
+	}
+
+	/**
+	 * Process a block of audio. At most Channels() channels are processed, the rest
+	 * of the output is left untouched.
+	 * @param in input channels
+	 * @param out output channels, may be the same as in
+	 * @param channels amount of channels
+	 * @param frames amount of samples per channel
+	 */
+	void Process(const float* const* in, float* const* out, int channels, int frames)
+	{
+		assert(channels <= m_Channels);
+		channels = std::min(channels, m_Channels);
+		if (channels <= 0)
+			return;
+
+		const int k = std::max(controlRate, 1);
+		const int stages = 2 * (m_Bands - 1);
+		Parameters(k);
+		for (int offset = 0; offset < frames; offset += BlockSize)
+		{
+			const int n = std::min(BlockSize, frames - offset);
+
+			// Every lane gets the same input, the stages split it in bands
+			for (int c = 0; c < channels; c++)
+			{
+				Frame* v = &m_Split[c * BlockSize];
+				for (int i = 0; i < n; i++)
+					for (size_t l = 0; l < Lanes; l++)
+						v[i][l] = in[c][offset + i];
+			}
+
+			// Channels are split Interleave at a time, when the bands fit in a single
+			// vector the other lanes are skipped
+			for (int c = 0; c < channels; c += Interleave)
+			{
+				if (channels - c >= Interleave)
+					Split<Interleave>(c, stages, n);
+				else
+					for (int r = c; r < channels; r++)
+						Split<1>(r, stages, n);
+			}
+
+			for (int i = 0; i < n; i += k)
+			{
+				const int m = std::min(k, n - i);
+				if (m != k)
+					Parameters(m);
+
+				Peaks(channels, i, m);
+				const int detectors = Link(channels);
+				for (int d = 0; d < detectors; d++)
+					Detect(m_Detectors[d], m_Level[d], m_Target[d]);
+
+				for (int c = 0; c < channels; c++)
+					Apply(c, i, m, out[c] + offset + i);
+
+				if (m != k)
+					Parameters(k);
+			}
+		}
+	}
+
+private:
+	static constexpr int Stages = 2 * (MaxBands - 1);
+	static constexpr int Interleave = 2; // Channels split together
+	static inline const double DC_OFFSET = Compressor::DC_OFFSET;
+
+	// Samples or values of all bands
+	struct alignas(SIMD_BYTES) Frame : std::array<float, Lanes> {};
+
+	struct alignas(SIMD_BYTES) Coefficients
+	{
+		float b0[Lanes], b1[Lanes], b2[Lanes], a1[Lanes], a2[Lanes];
+	};
+
+	struct alignas(SIMD_BYTES) State
+	{
+		float x1[Lanes]{}, x2[Lanes]{}, y1[Lanes]{}, y2[Lanes]{};
+	};
+
+	// Band settings in lanes, bands that aren't used have a gain of 0
+	struct alignas(SIMD_BYTES) LaneParameters
+	{
+		float pregain[Lanes], postgain[Lanes], mix[Lanes];
+		float expanderThreshhold[Lanes], compressThreshhold[Lanes];
+		float expanderRatio[Lanes], compressRatio[Lanes];
+		float att[Lanes], rel[Lanes];
+		float active[Lanes]; // 0 after 100 silent samples
+	};
+
+	struct alignas(SIMD_BYTES) Detector
+	{
+		Detector()
+		{
+			std::fill(std::begin(expanderEnv), std::end(expanderEnv), (float)DC_OFFSET);
+			std::fill(std::begin(compressEnv), std::end(compressEnv), (float)DC_OFFSET);
+			std::fill(std::begin(expanderMult), std::end(expanderMult), 1.0f);
+			std::fill(std::begin(compressMult), std::end(compressMult), 1.0f);
+		}
+
+		float expanderEnv[Lanes], compressEnv[Lanes];
+		float expanderMult[Lanes], compressMult[Lanes];
+	};
+
+	int m_Bands = 4;
+	int m_Channels = 0;
+	int m_Lookahead = 0;
+	double m_SampleRate = 48000;
+	double m_Crossover[MaxBands - 1]{ 100, 1000, 5000, 10000 };
+
+	// Two biquad stages per crossover
+	Coefficients m_Stages[Stages];
+	std::vector<std::array<State, Stages>> m_State;
+
+	LaneParameters m_Parameters;
+	int m_ZeroCounter[Lanes]{};
+
+	// Per channel, the bands of BlockSize samples, their peaks and the current gain
+	std::vector<Frame> m_Split;
+	std::vector<Frame> m_Peak;
+	std::vector<Frame> m_Gain;
+	std::vector<int> m_Group;
+
+	// Per detector, indexed by channel when independent, by group when grouped
+	std::vector<Frame> m_Level;
+	std::vector<Frame> m_Target;
+	std::vector<Detector> m_Detectors;
+
+	// Lookahead delay lines, Lookahead samples of all bands per channel
+	std::vector<Frame> m_Delay;
+	std::vector<int> m_DelayPos;
+	std::vector<SlidingMaximum> m_Window; // Per channel per band
+
+	// Gain of 1 for the bands in use
+	Frame Unity() const
+	{
+		Frame f{};
+		std::fill(f.begin(), f.begin() + m_Bands, 1.0f);
+		return f;
+	}
+
+	void Allocate()
+	{
+		m_Delay.assign(m_Channels * m_Lookahead, {});
+		m_DelayPos.assign(m_Channels, 0);
+		m_Window.resize(m_Channels * MaxBands);
+		for (auto& w : m_Window)
+			w.Size(m_Lookahead + 1);
+	}
+
+	int DetectorOf(int channel) const
+	{
+		return linking == Compressor::Independent ? channel : linking == Compressor::Grouped ? m_Group[channel] : 0;
+	}
+
+	/**
+	 * Copy the band settings into lanes.
+	 * @param k samples per detector update
+	 */
+	void Parameters(int k)
+	{
+		LaneParameters& p = m_Parameters;
+		for (size_t l = 0; l < Lanes; l++)
+		{
+			const bool used = (int)l < m_Bands;
+			const Compressor& b = bands[used ? l : 0];
+			p.pregain[l] = used ? b.pregain : 0;
+			p.postgain[l] = used ? b.postgain : 0;
+			p.mix[l] = b.mix;
+			p.expanderThreshhold[l] = b.expanderThreshhold, p.compressThreshhold[l] = b.compressThreshhold;
+			p.expanderRatio[l] = b.expanderRatio, p.compressRatio[l] = b.compressRatio;
+			p.att[l] = std::pow(b.attcoef, k), p.rel[l] = std::pow(b.relcoef, k);
+		}
+	}
+
+	/**
+	 * Peaks of all bands of every channel over m samples, and the silence counters.
+	 */
+	void Peaks(int channels, int i, int m)
+	{
+		alignas(SIMD_BYTES) float loudest[Lanes]{};
+		for (int c = 0; c < channels; c++)
+		{
+			const Frame* v = &m_Split[c * BlockSize + i];
+			Frame& peak = m_Peak[c];
+			peak.fill(0);
+			if (m_Lookahead == 0)
+			{
+				for (int j = 0; j < m; j++)
+					for (size_t l = 0; l < Lanes; l++)
+						peak[l] = std::max(peak[l], std::abs(v[j][l]));
+			}
+			else
+			{
+				SlidingMaximum* window = &m_Window[c * MaxBands];
+				for (int b = 0; b < m_Bands; b++)
+					for (int j = 0; j < m; j++)
+						peak[b] = std::max(peak[b], window[b].Process(std::abs(v[j][b])));
+			}
+
+			for (size_t l = 0; l < Lanes; l++)
+				loudest[l] = std::max(loudest[l], peak[l]);
+		}
+
+		for (size_t l = 0; l < Lanes; l++)
+		{
+			m_ZeroCounter[l] = loudest[l] == 0 ? std::min(m_ZeroCounter[l] + m, 101) : 0;
+			m_Parameters.active[l] = m_ZeroCounter[l] > 100 ? 0.0f : 1.0f;
+		}
+	}
+
+	/**
+	 * Combine the channel peaks into the detector levels.
+	 * @return amount of detectors
+	 */
+	int Link(int channels)
+	{
+		switch (linking)
+		{
+		case Compressor::Independent:
+			std::copy(m_Peak.begin(), m_Peak.begin() + channels, m_Level.begin());
+			return channels;
+		case Compressor::Max:
+		{
+			Frame& level = m_Level[0];
+			level = m_Peak[0];
+			for (int c = 1; c < channels; c++)
+				for (size_t l = 0; l < Lanes; l++)
+					level[l] = std::max(level[l], m_Peak[c][l]);
+			return 1;
+		}
+		case Compressor::Average:
+		{
+			Frame& level = m_Level[0];
+			level.fill(0);
+			for (int c = 0; c < channels; c++)
+				for (size_t l = 0; l < Lanes; l++)
+					level[l] += m_Peak[c][l];
+			const float scale = channels > 0 ? 1.0f / channels : 0;
+			for (size_t l = 0; l < Lanes; l++)
+				level[l] *= scale;
+			return 1;
+		}
+		case Compressor::Grouped:
+		{
+			int groups = 0;
+			std::fill(m_Level.begin(), m_Level.begin() + channels, Frame{});
+			for (int c = 0; c < channels; c++)
+			{
+				Frame& level = m_Level[m_Group[c]];
+				for (size_t l = 0; l < Lanes; l++)
+					level[l] = std::max(level[l], m_Peak[c][l]);
+				groups = std::max(groups, m_Group[c] + 1);
+			}
+			return groups;
+		}
+		}
+		return 0;
+	}
+
+	/**
+	 * Compressor::Detect for all bands at once, and the gain they result in. The dB
+	 * conversions use FastLog2 and FastExp2 so the lanes vectorize.
+	 * @param d detector
+	 * @param level peak per band
+	 * @param target resulting gain per band
+	 */
+	void Detect(Detector& d, const Frame& level, Frame& target)
+	{
+		constexpr float dB = 6.02059991f;            // 20 log10(2), log2 to dB
+		constexpr float lin = 0.166096405f;          // log2(10) / 20, dB to log2
+		const float offset = (float)DC_OFFSET;       // Avoids log(0) and denormals
+
+		// Local copies so the compiler knows nothing aliases
+		alignas(SIMD_BYTES) float expanderEnv[Lanes], compressEnv[Lanes], expanderMult[Lanes], compressMult[Lanes], gain[Lanes];
+		std::copy(std::begin(d.expanderEnv), std::end(d.expanderEnv), expanderEnv);
+		std::copy(std::begin(d.compressEnv), std::end(d.compressEnv), compressEnv);
+
+		const LaneParameters& p = m_Parameters;
+		for (size_t l = 0; l < Lanes; l++)
+		{
+			// Expander. min(x, 0) and max(x, 0) are written with abs, as
+			// branches here would stop the vectorizer.
+			float s = std::abs(level[l] * p.pregain[l]);
+			float x = dB * FastLog2(s + offset) - p.expanderThreshhold[l];
+			float over = 0.5f * (x - std::abs(x)) + offset;
+			const float att = p.att[l], rel = p.rel[l];
+			float coef = over > expanderEnv[l] ? att : rel;
+			expanderEnv[l] = over + coef * (expanderEnv[l] - over);
+			expanderMult[l] = FastExp2(lin * (expanderEnv[l] - offset) * (p.expanderRatio[l] - 1) * p.mix[l]);
+
+			// Compressor, on the expanded level
+			s *= expanderMult[l];
+			x = dB * FastLog2(s + offset) - p.compressThreshhold[l];
+			over = 0.5f * (x + std::abs(x)) + offset;
+			coef = over > compressEnv[l] ? att : rel;
+			compressEnv[l] = over + coef * (compressEnv[l] - over);
+			compressMult[l] = FastExp2(lin * (compressEnv[l] - offset) * (p.compressRatio[l] - 1) * p.mix[l]);
+
+			// Anything below -300 dB is silent, flushing it keeps the gain stage out of denormals
+			const float g = p.active[l] * p.pregain[l] * expanderMult[l] * compressMult[l] * p.postgain[l];
+			gain[l] = g > 1e-15f ? g : 0.0f;
+		}
+
+		std::copy(std::begin(expanderEnv), std::end(expanderEnv), d.expanderEnv);
+		std::copy(std::begin(compressEnv), std::end(compressEnv), d.compressEnv);
+		std::copy(std::begin(expanderMult), std::end(expanderMult), d.expanderMult);
+		std::copy(std::begin(compressMult), std::end(compressMult), d.compressMult);
+		std::copy(std::begin(gain), std::end(gain), target.begin());
+	}
+
+	/**
+	 * Ramp the gain of every band of a channel to its target over m samples, and sum the bands.
+	 */
+	void Apply(int c, int i, int m, float* y)
+	{
+		const Frame* v = &m_Split[c * BlockSize + i];
+		const Frame& target = m_Target[DetectorOf(c)];
+
+		// Local copies so the compiler knows the output doesn't alias the gain
+		alignas(SIMD_BYTES) float gain[Lanes], step[Lanes];
+		for (size_t l = 0; l < Lanes; l++)
+			gain[l] = m_Gain[c][l], step[l] = (target[l] - gain[l]) / m;
+
+		if (m_Lookahead == 0)
+			for (int j = 0; j < m; j++)
+				y[j] = Sum(v[j], gain, step);
+		else
+		{
+			Frame* delay = &m_Delay[c * m_Lookahead];
+			int pos = m_DelayPos[c];
+			for (int j = 0; j < m; j++)
+			{
+				Frame x = v[j];
+				std::swap(x, delay[pos]);
+				pos = pos + 1 == m_Lookahead ? 0 : pos + 1;
+				y[j] = Sum(x, gain, step);
+			}
+			m_DelayPos[c] = pos;
+		}
+
+		m_Gain[c] = target;
+	}
+
+	/**
+	 * Step the gain of every band and sum the bands with it. The lanes are added in
+	 * halves so the sum stays vectorized down to the last vector.
+	 */
+	static inline float Sum(const Frame& x, float* gain, const float* step)
+	{
+		alignas(SIMD_BYTES) float p[Lanes];
+		for (size_t l = 0; l < Lanes; l++)
+			gain[l] += step[l], p[l] = x[l] * gain[l];
+		for (size_t h = Lanes / 2; h > 0; h /= 2)
+			for (size_t l = 0; l < h; l++)
+				p[l] += p[l + h];
+		return p[0];
+	}
+
+	void RecalculateParameters()
+	{
+		for (int j = 0; j < MaxBands - 1; j++)
+		{
+			// LR4 is a squared Butterworth, the sum of its low and highpass is a
+			// second order allpass with the same Q
+			BiquadParameters lp, hp, ap;
+			lp.type = FilterType::LowPass, hp.type = FilterType::HighPass, ap.type = FilterType::AllPass;
+			for (auto* p : { &lp, &hp, &ap })
+				p->Q = 0.70710678118, p->f0 = m_Crossover[j], p->sampleRate = m_SampleRate, p->RecalculateParameters();
+
+			for (size_t b = 0; b < Lanes; b++)
+			{
+				const BiquadParameters& p = (int)b < j ? ap : (int)b == j ? lp : hp;
+				Set(m_Stages[2 * j], b, p.b0a0, p.b1a0, p.b2a0, p.a1a0, p.a2a0);
+				if ((int)b < j)
+					Set(m_Stages[2 * j + 1], b, 1, 0, 0, 0, 0);
+				else
+					Set(m_Stages[2 * j + 1], b, p.b0a0, p.b1a0, p.b2a0, p.a1a0, p.a2a0);
+			}
+		}
+	}
+
+	static void Set(Coefficients& c, size_t l, double b0, double b1, double b2, double a1, double a2)
+	{
+		c.b0[l] = b0, c.b1[l] = b1, c.b2[l] = b2, c.a1[l] = a1, c.a2[l] = a2;
+	}
+
+	/**
+	 * Split P channels from c in bands.
+	 */
+	template<size_t P>
+	void Split(int c, int stages, int n)
+	{
+		State* s[P];
+		Frame* v[P];
+		for (int t = 0; t < stages; t++)
+		{
+			for (size_t p = 0; p < P; p++)
+				s[p] = &m_State[c + p][t], v[p] = &m_Split[(c + p) * BlockSize];
+
+			if (m_Bands <= (int)Width)
+				ApplyStage<Width, P>(m_Stages[t], s, v, n);
+			else
+				ApplyStage<Lanes, P>(m_Stages[t], s, v, n);
+		}
+	}
+
+	/**
+	 * Apply a crossover stage to the first L lanes of P channels. A biquad waits for its
+	 * previous output, filtering several channels in the same loop keeps their
+	 * recursions in flight together.
+	 */
+	template<size_t L, size_t P>
+	static void ApplyStage(const Coefficients& c, State* const* s, Frame* const* v, int n)
+	{
+		// Local copies so the compiler knows nothing aliases the buffer
+		alignas(SIMD_BYTES) Coefficients k = c;
+		alignas(SIMD_BYTES) float x1[P][Lanes], x2[P][Lanes], y1[P][Lanes], y2[P][Lanes];
+		for (size_t p = 0; p < P; p++)
+		{
+			std::copy(std::begin(s[p]->x1), std::end(s[p]->x1), x1[p]), std::copy(std::begin(s[p]->x2), std::end(s[p]->x2), x2[p]);
+			std::copy(std::begin(s[p]->y1), std::end(s[p]->y1), y1[p]), std::copy(std::begin(s[p]->y2), std::end(s[p]->y2), y2[p]);
+		}
+
+		for (int i = 0; i < n; i++)
+			for (size_t p = 0; p < P; p++)
+			{
+				Frame& f = v[p][i];
+				for (size_t l = 0; l < L; l++)
+				{
+					// The feedback of the last output is subtracted last, so only it is on the recursion
+					float x0 = f[l];
+					float y0 = k.b0[l] * x0 + k.b1[l] * x1[p][l] + k.b2[l] * x2[p][l] - k.a2[l] * y2[p][l] - k.a1[l] * y1[p][l];
+					x2[p][l] = x1[p][l], x1[p][l] = x0;
+					y2[p][l] = y1[p][l], y1[p][l] = y0;
+					f[l] = y0;
+				}
+			}
+
+		for (size_t p = 0; p < P; p++)
+		{
+			std::copy(std::begin(x1[p]), std::end(x1[p]), s[p]->x1), std::copy(std::begin(x2[p]), std::end(x2[p]), s[p]->x2);
+			std::copy(std::begin(y1[p]), std::end(y1[p]), s[p]->y1), std::copy(std::begin(y2[p]), std::end(y2[p]), s[p]->y2);
+		}
+	}
+};
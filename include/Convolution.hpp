@@ -0,0 +1,408 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "FFT.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Read-only, memory-mapped impulse response file. Samples are decoded straight from
+ * the mapped file, so long responses can be loaded without copying them first.
+ * Supports WAV files (16/24/32 bit PCM and 32 bit float) and raw 32 bit float files.
+ */
+class ImpulseResponse
+{
+public:
+	enum class Format
+	{
+		Wav, Raw
+	};
+
+	ImpulseResponse() = default;
+
+	/**
+	 * Constructor.
+	 * @param path file path
+	 * @param format file format
+	 * @param channels amount of interleaved channels, only used for raw files
+	 */
+	ImpulseResponse(const std::string& path, Format format = Format::Wav, int channels = 1) { Open(path, format, channels); }
+
+	ImpulseResponse(const ImpulseResponse&) = delete;
+	ImpulseResponse& operator=(const ImpulseResponse&) = delete;
+
+	~ImpulseResponse() { Close(); }
+
+	/**
+	 * Map a file.
+	 * @param path file path
+	 * @param format file format
+	 * @param channels amount of interleaved channels, only used for raw files
+	 * @return true when the file was mapped and understood
+	 */
+	bool Open(const std::string& path, Format format = Format::Wav, int channels = 1)
+	{
+		Close();
+		if (!Map(path))
+			return false;
+
+		bool valid = format == Format::Wav ? ParseWav() : ParseRaw(channels);
+		if (!valid)
+			Close();
+
+		return valid;
+	}
+
+	/**
+	 * Unmap the file.
+	 */
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_Map) UnmapViewOfFile(m_Map);
+		if (m_Mapping) CloseHandle(m_Mapping);
+		if (m_File && m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+		m_Mapping = nullptr, m_File = nullptr;
+#else
+		if (m_Map) munmap(const_cast<uint8_t*>(m_Map), m_MapSize);
+#endif
+		m_Map = nullptr, m_Data = nullptr;
+		m_MapSize = 0, m_Frames = 0, m_Channels = 0, m_SampleRate = 0;
+	}
+
+	/**
+	 * Returns true when a file is mapped.
+	 */
+	bool Valid() const { return m_Data != nullptr; }
+
+	/**
+	 * Amount of samples per channel.
+	 */
+	size_t Length() const { return m_Frames; }
+
+	/**
+	 * Amount of channels.
+	 */
+	int Channels() const { return m_Channels; }
+
+	/**
+	 * Samplerate stored in the file, 0 for raw files.
+	 */
+	double SampleRate() const { return m_SampleRate; }
+
+	/**
+	 * Decode a single sample from the mapped file.
+	 * @param frame sample index
+	 * @param channel channel
+	 * @return sample
+	 */
+	float Sample(size_t frame, int channel = 0) const
+	{
+		const uint8_t* p = m_Data + (frame * m_Channels + channel) * m_Bytes;
+		switch (m_Encoding)
+		{
+		case Encoding::Float32: { float v; std::memcpy(&v, p, 4); return v; }
+		case Encoding::Pcm16: { int16_t v; std::memcpy(&v, p, 2); return v / 32768.0f; }
+		case Encoding::Pcm24: { int32_t v = (p[0] << 8) | (p[1] << 16) | (p[2] << 24); return (v >> 8) / 8388608.0f; }
+		case Encoding::Pcm32: { int32_t v; std::memcpy(&v, p, 4); return v / 2147483648.0f; }
+		}
+		return 0;
+	}
+
+private:
+	enum class Encoding
+	{
+		Float32, Pcm16, Pcm24, Pcm32
+	};
+
+	const uint8_t* m_Map = nullptr;
+	const uint8_t* m_Data = nullptr;
+	size_t m_MapSize = 0;
+	size_t m_Frames = 0;
+	int m_Channels = 0;
+	int m_Bytes = 4;
+	double m_SampleRate = 0;
+	Encoding m_Encoding = Encoding::Float32;
+
+#ifdef _WIN32
+	HANDLE m_File = nullptr, m_Mapping = nullptr;
+#endif
+
+	bool Map(const std::string& path)
+	{
+#ifdef _WIN32
+		m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_File == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+			return false;
+
+		m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_Mapping)
+			return false;
+
+		m_Map = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		m_MapSize = size.QuadPart;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (map == MAP_FAILED)
+			return false;
+
+		m_Map = static_cast<const uint8_t*>(map);
+		m_MapSize = st.st_size;
+#endif
+		return m_Map != nullptr;
+	}
+
+	uint32_t Read32(size_t offset) const { uint32_t v; std::memcpy(&v, m_Map + offset, 4); return v; }
+	uint16_t Read16(size_t offset) const { uint16_t v; std::memcpy(&v, m_Map + offset, 2); return v; }
+
+	bool ParseRaw(int channels)
+	{
+		if (channels <= 0)
+			return false;
+
+		m_Encoding = Encoding::Float32, m_Bytes = 4;
+		m_Channels = channels;
+		m_Frames = m_MapSize / (4 * channels);
+		m_Data = m_Map;
+		return m_Frames > 0;
+	}
+
+	bool ParseWav()
+	{
+		if (m_MapSize < 12 || std::memcmp(m_Map, "RIFF", 4) != 0 || std::memcmp(m_Map + 8, "WAVE", 4) != 0)
+			return false;
+
+		int format = 0, bits = 0;
+		const uint8_t* data = nullptr;
+		size_t dataSize = 0;
+		for (size_t pos = 12; pos + 8 <= m_MapSize;)
+		{
+			size_t size = Read32(pos + 4);
+			size_t body = pos + 8;
+			if (std::memcmp(m_Map + pos, "fmt ", 4) == 0 && size >= 16 && body + size <= m_MapSize)
+			{
+				format = Read16(body);
+				m_Channels = Read16(body + 2);
+				m_SampleRate = Read32(body + 4);
+				bits = Read16(body + 14);
+				if (format == 0xFFFE && size >= 26) // WAVE_FORMAT_EXTENSIBLE, format is in the sub format
+					format = Read16(body + 24);
+			}
+			else if (std::memcmp(m_Map + pos, "data", 4) == 0)
+			{
+				data = m_Map + body;
+				dataSize = std::min(size, m_MapSize - body);
+			}
+			pos = body + size + (size & 1);
+		}
+
+		if (!data || m_Channels <= 0)
+			return false;
+
+		if (format == 3 && bits == 32) m_Encoding = Encoding::Float32;
+		else if (format == 1 && bits == 16) m_Encoding = Encoding::Pcm16;
+		else if (format == 1 && bits == 24) m_Encoding = Encoding::Pcm24;
+		else if (format == 1 && bits == 32) m_Encoding = Encoding::Pcm32;
+		else return false;
+
+		m_Bytes = bits / 8;
+		m_Data = data;
+		m_Frames = dataSize / (m_Bytes * m_Channels);
+		return m_Frames > 0;
+	}
+};
+
+/**
+ * Uniformly partitioned overlap-save convolution. The impulse response is split into
+ * partitions of Block() samples which are transformed once when loaded; every Block()
+ * input samples a single FFT of 2 * Block() is multiplied with all partitions in a
+ * frequency domain delay line. Output is delayed by Latency() == Block() samples.
+ */
+class PartitionedConvolver
+{
+public:
+	using Complex = FFT::Complex;
+
+	/**
+	 * Allocate all buffers, no allocations happen after this.
+	 * @param block partition size, must be a power of 2
+	 * @param length maximum length of the impulse response
+	 */
+	void Size(size_t block, size_t length)
+	{
+		m_Block = block;
+		m_Bins = block + 1;
+		m_Partitions = std::max<size_t>(1, (length + block - 1) / block);
+		m_FFT.Size(2 * block);
+		m_Kernel.assign(m_Partitions * m_Bins, Complex{});
+		m_Delay.assign(m_Partitions * m_Bins, Complex{});
+		m_Accumulator.assign(m_Bins, Complex{});
+		m_Input.assign(2 * block, 0);
+		m_Output.assign(block, 0);
+		m_Time.assign(2 * block, 0);
+		m_Position = 0;
+		m_Head = 0;
+	}
+
+	/**
+	 * Load an impulse response from a function that returns each sample.
+	 * Samples beyond the size given to Size() are ignored.
+	 * @param length length of the impulse response
+	 * @param sample function returning the sample at an index
+	 */
+	template<typename Fun>
+	void Load(size_t length, Fun sample)
+	{
+		const size_t block = m_Block;
+		length = std::min(length, m_Partitions * block);
+		for (size_t p = 0; p < m_Partitions; p++)
+		{
+			size_t start = p * block;
+			for (size_t i = 0; i < block; i++)
+				m_Time[i] = start + i < length ? (float)sample(start + i) : 0;
+			std::fill(m_Time.begin() + m_Block, m_Time.end(), 0.0f);
+			m_FFT.Forward(m_Time.data(), &m_Kernel[p * m_Bins]);
+		}
+	}
+
+	/**
+	 * Load an impulse response from memory.
+	 * @param h impulse response
+	 * @param length length of the impulse response
+	 */
+	template<typename T>
+	void Load(const T* h, size_t length) { Load(length, [h](size_t i) { return h[i]; }); }
+
+	/**
+	 * Load an impulse response directly from a mapped file.
+	 * @param ir impulse response file
+	 * @param channel channel of the file to use
+	 */
+	void Load(const ImpulseResponse& ir, int channel = 0) { Load(ir.Length(), [&](size_t i) { return ir.Sample(i, channel); }); }
+
+	/**
+	 * Process a single sample.
+	 * @param in sample
+	 * @return sample from Latency() samples ago, convolved
+	 */
+	float Process(float in)
+	{
+		m_Input[m_Block + m_Position] = in;
+		float out = m_Output[m_Position];
+		if (++m_Position == m_Block)
+			ProcessPartition();
+		return out;
+	}
+
+	/**
+	 * Process a block of samples, in and out may point to the same buffer.
+	 * @param in input samples
+	 * @param out output samples
+	 * @param frames amount of samples
+	 */
+	void Process(const float* in, float* out, int frames)
+	{
+		while (frames > 0)
+		{
+			int n = std::min(frames, Remaining());
+			std::copy(in, in + n, m_Input.begin() + m_Block + m_Position);
+			std::copy(m_Output.begin() + m_Position, m_Output.begin() + m_Position + n, out);
+			m_Position += n, in += n, out += n, frames -= n;
+			if (m_Position == m_Block)
+				ProcessPartition();
+		}
+	}
+
+	/**
+	 * Clear all delay lines.
+	 */
+	void Reset()
+	{
+		std::fill(m_Delay.begin(), m_Delay.end(), Complex{});
+		std::fill(m_Input.begin(), m_Input.end(), 0.0f);
+		std::fill(m_Output.begin(), m_Output.end(), 0.0f);
+		m_Position = 0;
+	}
+
+	/**
+	 * Latency in samples.
+	 */
+	int Latency() const { return m_Block; }
+
+	/**
+	 * Partition size.
+	 */
+	int Block() const { return m_Block; }
+
+	/**
+	 * Amount of samples until the next partition is processed.
+	 */
+	int Remaining() const { return m_Block - m_Position; }
+
+private:
+	RealFFT m_FFT;
+	std::vector<Complex> m_Kernel;
+	std::vector<Complex> m_Delay;
+	std::vector<Complex> m_Accumulator;
+	std::vector<float> m_Input;
+	std::vector<float> m_Output;
+	std::vector<float> m_Time;
+	size_t m_Bins = 0, m_Partitions = 0, m_Head = 0;
+	int m_Block = 0, m_Position = 0;
+
+	void ProcessPartition()
+	{
+		m_FFT.Forward(m_Input.data(), &m_Delay[m_Head * m_Bins]);
+
+		// Multiply the spectrum of the input from p blocks ago with partition p
+		std::fill(m_Accumulator.begin(), m_Accumulator.end(), Complex{});
+		Complex* acc = m_Accumulator.data();
+		for (size_t p = 0; p < m_Partitions; p++)
+		{
+			const Complex* x = &m_Delay[((m_Head + p) % m_Partitions) * m_Bins];
+			const Complex* h = &m_Kernel[p * m_Bins];
+			for (size_t k = 0; k < m_Bins; k++)
+				acc[k] += FFT::Mul(x[k], h[k]);
+		}
+
+		m_FFT.Inverse(acc, m_Time.data());
+
+		// Only the second half is free of circular aliasing
+		std::copy(m_Time.begin() + m_Block, m_Time.end(), m_Output.begin());
+		std::copy(m_Input.begin() + m_Block, m_Input.end(), m_Input.begin());
+		m_Head = (m_Head + m_Partitions - 1) % m_Partitions;
+		m_Position = 0;
+	}
+};
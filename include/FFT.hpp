@@ -0,0 +1,219 @@
+#pragma once
+#include <cmath>
+#include <complex>
+#include <vector>
+
+/**
+ * In-place complex FFT for power of 2 sizes. Uses radix-4 butterflies, with a single
+ * radix-2 stage when the size is an odd power of 2. Twiddles and the bit-reversal
+ * table are calculated in Size(), so transforms never allocate.
+ */
+class FFT
+{
+public:
+	using Complex = std::complex<float>;
+
+	FFT(size_t n = 0) { Size(n); }
+
+	/**
+	 * Set the size of the transform, must be a power of 2.
+	 * @param n size
+	 */
+	void Size(size_t n)
+	{
+		m_Size = n;
+		m_Log = 0;
+		while ((size_t(1) << m_Log) < n)
+			m_Log++;
+
+		m_Twiddles.resize(n);
+		for (size_t i = 0; i < n; i++)
+			m_Twiddles[i] = std::polar(1.0, -6.28318530717958647 * i / n);
+
+		m_Reverse.resize(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			size_t r = 0;
+			for (size_t b = 0; b < m_Log; b++)
+				r |= ((i >> b) & 1) << (m_Log - 1 - b);
+			m_Reverse[i] = r;
+		}
+	}
+
+	/**
+	 * Get the size of the transform.
+	 * @return size
+	 */
+	size_t Size() const { return m_Size; }
+
+	/**
+	 * Forward transform, not normalized.
+	 * @param data Size() complex values
+	 */
+	void Forward(Complex* data) { Transform<false>(data); }
+
+	/**
+	 * Inverse transform, normalized by 1 / Size().
+	 * @param data Size() complex values
+	 */
+	void Inverse(Complex* data)
+	{
+		Transform<true>(data);
+		const float scale = 1.0f / m_Size;
+		for (size_t i = 0; i < m_Size; i++)
+			data[i] *= scale;
+	}
+
+	/**
+	 * Complex multiplication without the inf/nan handling of std::complex.
+	 */
+	static inline Complex Mul(const Complex& a, const Complex& b)
+	{
+		return { a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real() };
+	}
+
+private:
+	size_t m_Size = 0, m_Log = 0;
+	std::vector<std::complex<float>> m_Twiddles;
+	std::vector<size_t> m_Reverse;
+
+	template<bool Inv>
+	void Transform(Complex* x)
+	{
+		const size_t n = m_Size;
+		for (size_t i = 0; i < n; i++)
+			if (i < m_Reverse[i])
+				std::swap(x[i], x[m_Reverse[i]]);
+
+		size_t h = 1;
+		if (m_Log & 1)
+		{
+			for (size_t i = 0; i < n; i += 2)
+			{
+				Complex a = x[i], b = x[i + 1];
+				x[i] = a + b, x[i + 1] = a - b;
+			}
+			h = 2;
+		}
+
+		// Combine 4 transforms of size h into 1 of size 4h. With radix-2 bit-reversed
+		// input the sub transforms of residue 0, 2, 1, 3 are stored in that order.
+		for (; h < n; h *= 4)
+		{
+			const size_t stride = n / (4 * h);
+			for (size_t g = 0; g < n; g += 4 * h)
+			{
+				Complex* p = x + g;
+				for (size_t k = 0; k < h; k++)
+				{
+					Complex w1 = m_Twiddles[k * stride], w2 = m_Twiddles[2 * k * stride], w3 = m_Twiddles[3 * k * stride];
+					if constexpr (Inv)
+						w1 = std::conj(w1), w2 = std::conj(w2), w3 = std::conj(w3);
+
+					Complex t0 = p[k];
+					Complex t2 = Mul(w2, p[k + h]);
+					Complex t1 = Mul(w1, p[k + 2 * h]);
+					Complex t3 = Mul(w3, p[k + 3 * h]);
+
+					Complex s02 = t0 + t2, d02 = t0 - t2;
+					Complex s13 = t1 + t3, d13 = t1 - t3;
+
+					// -i * d13 for the forward transform, +i for the inverse
+					Complex r13 = Inv ? Complex{ -d13.imag(), d13.real() } : Complex{ d13.imag(), -d13.real() };
+
+					p[k] = s02 + s13;
+					p[k + h] = d02 + r13;
+					p[k + 2 * h] = s02 - s13;
+					p[k + 3 * h] = d02 - r13;
+				}
+			}
+		}
+	}
+};
+
+/**
+ * FFT of real signals, calculated with a complex FFT of half the size.
+ * A transform of Size() real samples results in Size() / 2 + 1 bins.
+ */
+class RealFFT
+{
+public:
+	using Complex = FFT::Complex;
+
+	RealFFT(size_t n = 0) { Size(n); }
+
+	/**
+	 * Set the size of the transform, must be a power of 2 and at least 2.
+	 * @param n size
+	 */
+	void Size(size_t n)
+	{
+		m_Size = n;
+		m_FFT.Size(n / 2);
+		m_Buffer.resize(n / 2);
+		m_Twiddles.resize(n / 2);
+		for (size_t i = 0; i < n / 2; i++)
+			m_Twiddles[i] = std::polar(1.0, -6.28318530717958647 * i / n);
+	}
+
+	/**
+	 * Get the size of the transform.
+	 * @return size
+	 */
+	size_t Size() const { return m_Size; }
+
+	/**
+	 * Forward transform, not normalized.
+	 * @param in Size() real samples
+	 * @param out Size() / 2 + 1 bins
+	 */
+	void Forward(const float* in, Complex* out)
+	{
+		const size_t h = m_Size / 2;
+		Complex* z = m_Buffer.data();
+		for (size_t i = 0; i < h; i++)
+			z[i] = { in[2 * i], in[2 * i + 1] };
+
+		m_FFT.Forward(z);
+
+		out[0] = { z[0].real() + z[0].imag(), 0 };
+		out[h] = { z[0].real() - z[0].imag(), 0 };
+		for (size_t k = 1; k < h; k++)
+		{
+			Complex a = z[k], b = std::conj(z[h - k]);
+			Complex even = (a + b) * 0.5f;
+			Complex diff = (a - b) * 0.5f;
+			Complex odd = { diff.imag(), -diff.real() };
+			out[k] = even + FFT::Mul(m_Twiddles[k], odd);
+		}
+	}
+
+	/**
+	 * Inverse transform, normalized by 1 / Size().
+	 * @param in Size() / 2 + 1 bins
+	 * @param out Size() real samples
+	 */
+	void Inverse(const Complex* in, float* out)
+	{
+		const size_t h = m_Size / 2;
+		Complex* z = m_Buffer.data();
+		for (size_t k = 0; k < h; k++)
+		{
+			Complex a = in[k], b = std::conj(in[h - k]);
+			Complex even = (a + b) * 0.5f;
+			Complex odd = FFT::Mul((a - b) * 0.5f, std::conj(m_Twiddles[k]));
+			z[k] = { even.real() - odd.imag(), even.imag() + odd.real() };
+		}
+
+		m_FFT.Inverse(z);
+
+		for (size_t i = 0; i < h; i++)
+			out[2 * i] = z[i].real(), out[2 * i + 1] = z[i].imag();
+	}
+
+private:
+	size_t m_Size = 0;
+	FFT m_FFT;
+	std::vector<Complex> m_Buffer;
+	std::vector<Complex> m_Twiddles;
+};
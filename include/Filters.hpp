@@ -1,9 +1,28 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <cmath>
+#include <vector>
+#include "Convolution.hpp"
+#include "LockFree.hpp"
 
 #define constrain(x, y, z) (x < y ? y : x > z ? z : x)
 
+// Width in bytes of the widest vector registers we compile for
+#if defined(__AVX512F__)
+#define SIMD_BYTES 64
+#elif defined(__AVX__)
+#define SIMD_BYTES 32
+#else
+#define SIMD_BYTES 16
+#endif
+
+// FastFIRFilters with more taps than this use FFT convolution instead of direct form
+#ifndef FIR_CONVOLUTION_THRESHOLD
+#define FIR_CONVOLUTION_THRESHOLD 512
+#endif
+
 enum class FilterType
 {
 	Off, LowPass, HighPass, BandPass, Notch, AllPass, PeakingEQ, LowShelf, HighShelf, ITEMS
@@ -15,6 +34,19 @@ class Filter
 public:
 	using Params = T;
 	virtual float Apply(float s, Params& p) = 0;
+
+	/**
+	 * Apply the filter to a block of samples, in and out may point to the same buffer.
+	 * @param in input samples
+	 * @param out output samples
+	 * @param frames amount of samples
+	 * @param p parameters
+	 */
+	virtual void Apply(const float* in, float* out, int frames, Params& p)
+	{
+		for (int i = 0; i < frames; i++)
+			out[i] = Apply(in[i], p);
+	}
 };
 
 
@@ -24,13 +56,14 @@ public:
 	virtual void RecalculateParameters() = 0;
 };
 
-template<size_t M>
+template<size_t M, typename T = double>
 class FIRFilterParameters : public FilterParameters
 {
 public:
+	using Coefficient = T;
 
 	// Coefficients
-	double H[M];
+	T H[M];
 };
 
 template<size_t M>
@@ -53,8 +86,31 @@ public:
 	double sampleRate = 48000;
 	FilterType type = FilterType::Off;
 
+	/**
+	 * Returns true when f0, Q, dbgain, type or sampleRate changed since the
+	 * coefficients were last calculated.
+	 */
+	bool Dirty() const
+	{
+		return !m_Designed || Q != m_Q || f0 != m_F0 || dbgain != m_DbGain || sampleRate != m_SampleRate || type != m_Type;
+	}
+
+	/**
+	 * Recalculate the coefficients, but only when they are dirty.
+	 * @return true when recalculated
+	 */
+	bool Update()
+	{
+		if (!Dirty())
+			return false;
+
+		RecalculateParameters();
+		return true;
+	}
+
 	void RecalculateParameters()
 	{
+		m_Designed = true, m_Q = Q, m_F0 = f0, m_DbGain = dbgain, m_SampleRate = sampleRate, m_Type = type;
 		w0 = 6.28318530718 * (constrain(f0, 10, sampleRate / 2.1) / sampleRate);
 		cosw0 = std::cos(w0), sinw0 = std::sin(w0);
 
@@ -140,6 +196,207 @@ public:
 
 	// Intermediate values
 	double w0 = 0, cosw0 = 0, sinw0 = 0, A = 0, alpha = 0;
+
+private:
+	// Parameters the coefficients were calculated with
+	bool m_Designed = false;
+	double m_Q = 0, m_F0 = 0, m_DbGain = 0, m_SampleRate = 0;
+	FilterType m_Type = FilterType::Off;
+};
+
+/**
+ * Calculates BiquadParameters coefficients on a non-realtime thread, and hands them
+ * to the audio thread with a lock-free swap. Design() is called on the UI or a worker
+ * thread, Fetch() at the top of each block on the audio thread.
+ */
+class BiquadDesigner
+{
+public:
+
+	/**
+	 * Calculate the coefficients for a set of parameters and publish them.
+	 * @param p parameters
+	 */
+	void Design(const BiquadParameters& p)
+	{
+		BiquadParameters& d = m_Buffer.Write();
+		d = p;
+		d.RecalculateParameters();
+		m_Buffer.Publish();
+	}
+
+	/**
+	 * Copy the newest published coefficients and parameters, doesn't block or allocate.
+	 * @param p parameters to update
+	 * @return true when there were new coefficients
+	 */
+	bool Fetch(BiquadParameters& p)
+	{
+		if (!m_Buffer.Update())
+			return false;
+
+		p = m_Buffer.Read();
+		return true;
+	}
+
+private:
+	TripleBuffer<BiquadParameters> m_Buffer;
+};
+
+/**
+ * Combined frequency response of a set of biquad bands at log-spaced frequencies, for
+ * drawing filter curves. The response of each band is cached and only recalculated
+ * when its coefficients change, all bands are assumed to share the same samplerate.
+ */
+class FrequencyResponse
+{
+public:
+
+	/**
+	 * Set the amount of frequencies and the range they span, invalidates the cache.
+	 * @param n amount of log-spaced frequencies
+	 * @param low lowest frequency in Hz
+	 * @param high highest frequency in Hz
+	 */
+	void Points(int n, double low = 10, double high = 22000)
+	{
+		m_Points = std::max(n, 2), m_Low = low, m_High = high;
+		m_SampleRate = 0;
+	}
+
+	/**
+	 * Enable calculating the phase response, which is off by default.
+	 * @param p phase
+	 */
+	void CalculatePhase(bool p) { if (p != m_CalculatePhase) m_CalculatePhase = p, m_SampleRate = 0; }
+
+	/**
+	 * Bring the response up to date with the bands, only changed bands are recalculated.
+	 * @param bands biquad bands
+	 * @return true when the response changed
+	 */
+	bool Update(const std::vector<BiquadParameters>& bands)
+	{
+		const double sampleRate = bands.empty() ? 48000 : bands[0].sampleRate;
+		bool changed = false;
+		if (sampleRate != m_SampleRate)
+			Allocate(sampleRate), changed = true;
+
+		if (m_Bands.size() != bands.size())
+			m_Bands.resize(bands.size()), changed = true;
+
+		for (size_t b = 0; b < bands.size(); b++)
+		{
+			Band& band = m_Bands[b];
+			const BiquadParameters& p = bands[b];
+			const double c[5]{ p.b0a0, p.b1a0, p.b2a0, p.a1a0, p.a2a0 };
+			const bool off = p.type == FilterType::Off;
+			if (band.valid && band.off == off && (off || std::equal(c, c + 5, band.c)))
+				continue;
+
+			band.valid = true, band.off = off;
+			std::copy(c, c + 5, band.c);
+			if (!off)
+				Evaluate(band);
+			changed = true;
+		}
+
+		if (changed)
+			Combine();
+
+		return changed;
+	}
+
+	/**
+	 * @return the frequencies in Hz
+	 */
+	const std::vector<double>& Frequencies() const { return m_Frequencies; }
+
+	/**
+	 * @return the combined magnitude response in dB
+	 */
+	const std::vector<double>& Magnitude() const { return m_Magnitude; }
+
+	/**
+	 * @return the combined phase response in radians, empty unless CalculatePhase(true)
+	 */
+	const std::vector<double>& Phase() const { return m_Phase; }
+
+private:
+	struct Band
+	{
+		bool valid = false, off = false;
+		double c[5]{};
+		std::vector<double> power, phase; // |H|^2 and arg H per frequency
+	};
+
+	int m_Points = 256;
+	double m_Low = 10, m_High = 22000, m_SampleRate = 0;
+	bool m_CalculatePhase = false;
+	std::vector<Band> m_Bands;
+	std::vector<double> m_Frequencies, m_Magnitude, m_Phase;
+	std::vector<double> m_Cos1, m_Sin1, m_Cos2, m_Sin2; // cos/sin of w and 2w
+
+	void Allocate(double sampleRate)
+	{
+		m_SampleRate = sampleRate;
+		m_Frequencies.resize(m_Points), m_Magnitude.resize(m_Points);
+		m_Phase.resize(m_CalculatePhase ? m_Points : 0);
+		m_Cos1.resize(m_Points), m_Sin1.resize(m_Points), m_Cos2.resize(m_Points), m_Sin2.resize(m_Points);
+
+		const double ratio = std::log(m_High / m_Low) / (m_Points - 1);
+		for (int i = 0; i < m_Points; i++)
+		{
+			m_Frequencies[i] = m_Low * std::exp(ratio * i);
+			const double w = 6.28318530718 * m_Frequencies[i] / sampleRate;
+			m_Cos1[i] = std::cos(w), m_Sin1[i] = std::sin(w);
+			m_Cos2[i] = std::cos(2 * w), m_Sin2[i] = std::sin(2 * w);
+		}
+
+		for (auto& band : m_Bands)
+			band.valid = false;
+	}
+
+	void Evaluate(Band& band)
+	{
+		band.power.resize(m_Points);
+		band.phase.resize(m_CalculatePhase ? m_Points : 0);
+
+		// H(e^jw) = (b0 + b1 e^-jw + b2 e^-2jw) / (1 + a1 e^-jw + a2 e^-2jw)
+		const double b0 = band.c[0], b1 = band.c[1], b2 = band.c[2], a1 = band.c[3], a2 = band.c[4];
+		const double* c1 = m_Cos1.data(), * s1 = m_Sin1.data(), * c2 = m_Cos2.data(), * s2 = m_Sin2.data();
+		double* power = band.power.data(), * phase = m_CalculatePhase ? band.phase.data() : nullptr;
+		for (int i = 0; i < m_Points; i++)
+		{
+			const double nr = b0 + b1 * c1[i] + b2 * c2[i], ni = b1 * s1[i] + b2 * s2[i];
+			const double dr = 1 + a1 * c1[i] + a2 * c2[i], di = a1 * s1[i] + a2 * s2[i];
+			power[i] = (nr * nr + ni * ni) / (dr * dr + di * di);
+			if (phase)
+				phase[i] = std::atan2(di, dr) - std::atan2(ni, nr);
+		}
+	}
+
+	void Combine()
+	{
+		// Multiply the power of all bands, then a single log per frequency
+		std::fill(m_Magnitude.begin(), m_Magnitude.end(), 1.0);
+		std::fill(m_Phase.begin(), m_Phase.end(), 0.0);
+		for (auto& band : m_Bands)
+		{
+			if (band.off)
+				continue;
+
+			if (m_CalculatePhase)
+				for (int i = 0; i < m_Points; i++)
+					m_Magnitude[i] *= band.power[i], m_Phase[i] += band.phase[i];
+			else
+				for (int i = 0; i < m_Points; i++)
+					m_Magnitude[i] *= band.power[i];
+		}
+
+		for (auto& m : m_Magnitude)
+			m = 10 * std::log10(std::max(m, 1e-30));
+	}
 };
 
 template<typename P = BiquadParameters>
@@ -160,22 +417,72 @@ public:
 		return y[0];
 	}
 
+	/**
+	 * When the coefficients changed since the previous block, they are linearly
+	 * interpolated over this block to avoid zipper noise.
+	 */
+	void Apply(const float* in, float* out, int frames, P& p) override
+	{
+		const double to[5]{ p.b0a0, p.b1a0, p.b2a0, p.a1a0, p.a2a0 };
+		if (!m_Started)
+			std::copy(to, to + 5, c), m_Started = true;
+
+		// Keep coefficients and state in registers for the whole block
+		double x1 = x[1], x2 = x[2], y1 = y[1], y2 = y[2];
+		if (frames > 0 && !std::equal(to, to + 5, c))
+		{
+			const double r = 1.0 / frames;
+			const double d0 = (to[0] - c[0]) * r, d1 = (to[1] - c[1]) * r, d2 = (to[2] - c[2]) * r;
+			const double d3 = (to[3] - c[3]) * r, d4 = (to[4] - c[4]) * r;
+			double b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+			for (int i = 0; i < frames; i++)
+			{
+				b0 += d0, b1 += d1, b2 += d2, a1 += d3, a2 += d4;
+				double x0 = in[i];
+				double y0 = constrain(b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2, -10000000, 10000000);
+				x2 = x1, x1 = x0;
+				y2 = y1, y1 = y0;
+				out[i] = y0;
+			}
+			std::copy(to, to + 5, c);
+		}
+		else
+		{
+			const double b0 = to[0], b1 = to[1], b2 = to[2], a1 = to[3], a2 = to[4];
+			for (int i = 0; i < frames; i++)
+			{
+				double x0 = in[i];
+				double y0 = constrain(b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2, -10000000, 10000000);
+				x2 = x1, x1 = x0;
+				y2 = y1, y1 = y0;
+				out[i] = y0;
+			}
+		}
+		x[0] = x[1] = x1, x[2] = x2;
+		y[0] = y[1] = y1, y[2] = y2;
+	}
+
 private:
 	double y[3]{ 0, 0, 0 }, x[3]{ 0, 0, 0 };
+	double c[5]{}; // Coefficients at the end of the last block
+	bool m_Started = false;
 };
 
-template<size_t M>
-class KaiserBesselParameters : public FIRFilterParameters<M>
+template<size_t M, typename T = double>
+class KaiserBesselParameters : public FIRFilterParameters<M, T>
 {
 public:
 	double sampleRate = 48000;
 	void RecalculateParameters()
 	{
-		// Calculate the impulse response
-		A[0] = 2 * (Fb - Fa) / sampleRate;
-		int _np = (M - 1) / 2;
-		for (int j = 1; j <= _np; j++)
-			A[j] = (std::sin(j * 6.28318530718 * Fb / sampleRate) - std::sin(j * 6.28318530718 * Fa / sampleRate)) / (j * 3.14159265359);
+		// Calculate the impulse response, the centre lies between 2 taps for even M
+		const double _centre = (M - 1) / 2.0;
+		for (size_t j = 0; j < M; j++)
+		{
+			double t = j - _centre;
+			A[j] = t == 0 ? 2 * (Fb - Fa) / sampleRate
+				: (std::sin(t * 6.28318530718 * Fb / sampleRate) - std::sin(t * 6.28318530718 * Fa / sampleRate)) / (t * 3.14159265359);
+		}
 
 		// Calculate alpha
 		double _alpha;
@@ -188,14 +495,14 @@ public:
 		else
 			_alpha = 0.5842 * std::pow((attenuation - 21), 0.4) + 0.07886 * (attenuation - 21);
 
-		// Window the ideal response with the Kaiser-Bessel window
+		// Window the ideal response with the Kaiser-Bessel window, it's symmetric around
+		// the centre so every tap is set, also the last one for even M
 		double _i0alpha = I0(_alpha);
-		for (int j = 0; j <= _np; j++)
-			this->H[_np + j] = A[j] * I0(_alpha * std::sqrt(1.0 - ((double)j * (double)j / (_np * _np)))) / _i0alpha;
-
-		// It is mirrored so other half is same
-		for (int j = 0; j < _np; j++)
-			this->H[j] = this->H[M - 1 - j];
+		for (size_t j = 0; j < M; j++)
+		{
+			double t = M > 1 ? (j - _centre) / _centre : 0;
+			this->H[j] = A[j] * I0(_alpha * std::sqrt(std::max(1.0 - t * t, 0.0))) / _i0alpha;
+		}
 	}
 
 	// This function calculates the zeroth order Bessel function
@@ -213,34 +520,220 @@ public:
 
 	double Fa = 0, Fb = 7200;	// Frequencies a and b
 	double attenuation = 48;	// Attenuation
-	double A[M];				// Ideal impulse response
+	double A[M];				// Ideal impulse response per tap
 };
 
+/**
+ * Direct form FIR filter. The history is a mirrored circular buffer, written at 2 positions
+ * so the newest samples are always contiguous and nothing is shifted per sample. The
+ * kernel runs in the coefficient type of the parameters, float coefficients
+ * (KaiserBesselParameters<M, float>) double the amount of taps per instruction.
+ */
 template<size_t M, typename P = KaiserBesselParameters<M>>
-class FIRFilter : public Filter<P>
+class DirectFIRFilter : public Filter<P>
 {
 public:
-	FIRFilter() { std::fill(std::begin(x), std::end(x), 0); }
+	using T = typename P::Coefficient;
+	static constexpr int BlockSize = 64;
+
+	// Outputs per block of the dot product
+	static constexpr int R = 4;
+
+	// Circular length, a block needs BlockSize - 1 samples of history beyond M
+	static constexpr size_t L = M + BlockSize - 1;
+
+	DirectFIRFilter() { std::fill(std::begin(x), std::end(x), 0); }
 
 	float Apply(float s, P& p) override
 	{
-		x[0] = s;
+		m_Write = (m_Write == 0 ? L : m_Write) - 1;
+		x[m_Write] = x[m_Write + L] = s;
+		return Dot(p.H, x + m_Write);
+	}
 
-		double y = 0;
-		for (int i = 0; i < M; i++)
-			y += p.H[i] * x[i];
+	void Apply(const float* in, float* out, int frames, P& p) override
+	{
+		while (frames > 0)
+		{
+			// Write a chunk that doesn't wrap around, newest sample ends up at w
+			size_t w = m_Write == 0 ? L : m_Write;
+			int n = std::min({ frames, BlockSize, (int)w });
+			for (int j = 0; j < n; j++)
+				w--, x[w] = x[w + L] = in[j];
+			m_Write = w;
 
-		for (int i = sizeof(x) / sizeof(double) - 2; i >= 0; i--)
-			x[i + 1] = x[i];
+			// Output j starts at w + n - 1 - j, calculate R outputs at a time so
+			// every loaded coefficient is used R times.
+			T y[BlockSize + R];
+			for (int r = 0; r < n; r += R)
+				Dot(p.H, x + w + r, y + r);
+
+			for (int j = 0; j < n; j++)
+				out[j] = y[n - 1 - j];
+
+			in += n, out += n, frames -= n;
+		}
+	}
+
+	/**
+	 * Latency in samples added on top of the response itself.
+	 */
+	int Latency() const { return 0; }
+
+private:
+	alignas(SIMD_BYTES) T x[2 * L];
+	size_t m_Write = 0;
+
+	static T Dot(const T* h, const T* v)
+	{
+		// Independent accumulators so the sum vectorizes without reassociation
+		constexpr size_t K = 2 * SIMD_BYTES / sizeof(T);
+		T acc[K]{};
+		size_t i = 0;
+		for (; i + K <= M; i += K)
+			for (size_t k = 0; k < K; k++)
+				acc[k] += h[i + k] * v[i + k];
+
+		T y = 0;
+		if constexpr (M % K != 0)
+			for (; i < M; i++)
+				y += h[i] * v[i];
+
+		for (size_t k = 0; k < K; k++)
+			y += acc[k];
 
 		return y;
 	}
 
+	static void Dot(const T* h, const T* v, T* y)
+	{
+		// 4 dot products with windows starting at v, v + 1, v + 2 and v + 3, sharing the
+		// coefficient loads. Written out per window so each accumulator stays in a register.
+		constexpr size_t K = SIMD_BYTES / sizeof(T);
+		T a0[K]{}, a1[K]{}, a2[K]{}, a3[K]{};
+		size_t i = 0;
+		for (; i + K <= M; i += K)
+			for (size_t k = 0; k < K; k++)
+			{
+				const T c = h[i + k];
+				a0[k] += c * v[i + k];
+				a1[k] += c * v[i + k + 1];
+				a2[k] += c * v[i + k + 2];
+				a3[k] += c * v[i + k + 3];
+			}
+
+		if constexpr (M % K != 0)
+			for (; i < M; i++)
+			{
+				a0[0] += h[i] * v[i];
+				a1[0] += h[i] * v[i + 1];
+				a2[0] += h[i] * v[i + 2];
+				a3[0] += h[i] * v[i + 3];
+			}
+
+		y[0] = y[1] = y[2] = y[3] = 0;
+		for (size_t k = 0; k < K; k++)
+			y[0] += a0[k], y[1] += a1[k], y[2] += a2[k], y[3] += a3[k];
+	}
+};
+
+/**
+ * FIR filter using uniformly partitioned FFT convolution, the cost per sample grows
+ * with the amount of partitions instead of the amount of taps. Adds B samples latency.
+ * The coefficients are compared at every partition boundary and only transformed again
+ * when they changed. Load an ImpulseResponse to convolve with a file instead, up to M
+ * samples of it are used and the coefficients in the parameters are ignored from then on.
+ */
+template<size_t M, typename P = KaiserBesselParameters<M>, size_t B = 64>
+class ConvolutionFIRFilter : public Filter<P>
+{
+public:
+	using T = typename P::Coefficient;
+
+	ConvolutionFIRFilter()
+	{
+		std::fill(std::begin(h), std::end(h), 0);
+		m_Convolver.Size(B, M);
+	}
+
+	float Apply(float s, P& p) override
+	{
+		if (m_Convolver.Remaining() == B)
+			Update(p);
+
+		return m_Convolver.Process(s);
+	}
+
+	void Apply(const float* in, float* out, int frames, P& p) override
+	{
+		while (frames > 0)
+		{
+			if (m_Convolver.Remaining() == B)
+				Update(p);
+
+			int n = std::min(frames, m_Convolver.Remaining());
+			m_Convolver.Process(in, out, n);
+			in += n, out += n, frames -= n;
+		}
+	}
+
+	/**
+	 * Transform the partitions straight from a mapped impulse response, not from the
+	 * coefficients in the parameters. Not realtime safe, call it before processing.
+	 * @param ir impulse response file
+	 * @param channel channel of the file to use
+	 */
+	void Load(const ImpulseResponse& ir, int channel = 0)
+	{
+		m_Convolver.Load(ir, channel);
+		m_External = true;
+	}
+
+	/**
+	 * Go back to using the coefficients in the parameters after Load().
+	 */
+	void Unload()
+	{
+		m_External = false;
+		std::fill(std::begin(h), std::end(h), 0);
+		m_Convolver.Load(h, M);
+	}
+
+	/**
+	 * Latency in samples added on top of the response itself.
+	 */
+	int Latency() const { return B; }
+
 private:
-	double x[M];
+	T h[M];
+	PartitionedConvolver m_Convolver;
+	bool m_External = false;
+
+	void Update(P& p)
+	{
+		if (m_External || std::equal(std::begin(h), std::end(h), std::begin(p.H)))
+			return;
+
+		std::copy(std::begin(p.H), std::end(p.H), std::begin(h));
+		m_Convolver.Load(h, M);
+	}
 };
 
-template<size_t N, class F, class P = F::Params>
+/**
+ * FIR filter, direct form so it never adds latency.
+ */
+template<size_t M, typename P = KaiserBesselParameters<M>>
+using FIRFilter = DirectFIRFilter<M, P>;
+
+/**
+ * FIR filter, uses direct form for short kernels and FFT convolution above
+ * FIR_CONVOLUTION_THRESHOLD taps. The convolution adds Latency() samples of delay,
+ * which has to be reported to the host, e.g. by returning it from PluginBase::Latency().
+ */
+template<size_t M, typename P = KaiserBesselParameters<M>>
+using FastFIRFilter = std::conditional_t<(M > FIR_CONVOLUTION_THRESHOLD), ConvolutionFIRFilter<M, P>, DirectFIRFilter<M, P>>;
+
+template<size_t N, class F, class P = typename F::Params>
 class ChannelEqualizer
 {
 public:
@@ -257,10 +750,227 @@ public:
 		return s;
 	}
 
+	/**
+	 * Apply all bands to a block of samples, in and out may point to the same buffer.
+	 * @param in input samples
+	 * @param out output samples
+	 * @param frames amount of samples
+	 */
+	void Apply(const float* in, float* out, int frames)
+	{
+		bool first = true;
+		for (size_t i = 0; i < N; i++)
+			if (m_Params[i].type != FilterType::Off)
+				m_Filters[i].Apply(first ? in : out, out, frames, m_Params[i]), first = false;
+
+		if (first && in != out)
+			std::copy(in, in + frames, out);
+	}
+
 	std::vector<P>& m_Params;
 	F m_Filters[N];
 };
 
+/**
+ * Equalizer with N biquad bands for any amount of channels. The filter state of all
+ * channels is stored in structure-of-arrays lanes, so every band processes Width
+ * channels (a vector of T) per instruction. By default it runs in double like
+ * BiquadFilter, which is 2/4/8 channels for SSE/AVX/AVX-512. With T = float it's twice
+ * as wide, but low frequency bands lose precision. A biquad has to wait for its previous
+ * output, so groups of Lanes channels, several vectors, are filtered at once to keep
+ * the recursions of different vectors in flight together.
+ */
+template<size_t N, typename T = double>
+class MultiChannelEqualizer
+{
+public:
+	static constexpr size_t Width = SIMD_BYTES / sizeof(T);
+	static constexpr size_t Lanes = 4 * Width;
+	static constexpr int BlockSize = 64;
+
+	MultiChannelEqualizer(std::vector<BiquadParameters>& a)
+		: m_Params(a)
+	{}
+
+	/**
+	 * Set the amount of channels, allocates the filter state.
+	 * @param c channels
+	 */
+	void Channels(int c)
+	{
+		m_Channels = c;
+		m_State.resize((c + Lanes - 1) / Lanes);
+	}
+
+	/**
+	 * Get the amount of channels.
+	 * @return channels
+	 */
+	int Channels() const { return m_Channels; }
+
+	/**
+	 * Apply all bands to a block of samples, in and out may point to the same buffers.
+	 * Changed coefficients are linearly interpolated over each chunk of BlockSize samples.
+	 * @param in input buffers, one per channel
+	 * @param out output buffers, one per channel
+	 * @param channels amount of channels, at most Channels(), any others are passed through
+	 * @param frames amount of samples per channel
+	 */
+	void Apply(const float* const* in, float* const* out, int channels, int frames)
+	{
+		assert(channels <= m_Channels);
+		for (int c = m_Channels; c < channels; c++)
+			if (in[c] != out[c])
+				std::copy(in[c], in[c] + frames, out[c]);
+
+		channels = std::min(channels, m_Channels);
+		for (int offset = 0; offset < frames; offset += BlockSize)
+		{
+			int n = std::min(BlockSize, frames - offset);
+			for (size_t b = 0; b < N; b++)
+			{
+				const BiquadParameters& p = m_Params[b];
+				m_To[b] = { (T)p.b0a0, (T)p.b1a0, (T)p.b2a0, (T)p.a1a0, (T)p.a2a0 };
+				if (!m_Started || p.type == FilterType::Off)
+					m_From[b] = m_To[b];
+			}
+			m_Started = true;
+
+			for (int g = 0; g * (int)Lanes < channels; g++)
+			{
+				int first = g * Lanes;
+				int lanes = std::min((int)Lanes, channels - first);
+
+				// Transpose the channels of this group into lanes, missing channels read zeros
+				static const float zeros[BlockSize]{};
+				const float* src[Lanes];
+				for (int l = 0; l < (int)Lanes; l++)
+					src[l] = l < lanes ? in[first + l] + offset : zeros;
+				for (int i = 0; i < n; i++)
+					for (size_t l = 0; l < Lanes; l++)
+						m_Buffer[i][l] = src[l][i];
+
+				// A group that fits in one vector only filters that vector
+				for (size_t b = 0; b < N; b++)
+				{
+					if (m_Params[b].type == FilterType::Off)
+						continue;
+
+					if (lanes <= (int)Width)
+						ApplyBand<Width>(m_From[b], m_To[b], m_State[g][b], n);
+					else
+						ApplyBand<Lanes>(m_From[b], m_To[b], m_State[g][b], n);
+				}
+
+				for (int l = 0; l < lanes; l++)
+					for (int i = 0; i < n; i++)
+						out[first + l][offset + i] = m_Buffer[i][l];
+			}
+
+			std::copy(std::begin(m_To), std::end(m_To), std::begin(m_From));
+		}
+	}
+
+	/**
+	 * Clear the filter state of all channels.
+	 */
+	void Reset() { std::fill(m_State.begin(), m_State.end(), std::array<State, N>{}); }
+
+	std::vector<BiquadParameters>& m_Params;
+
+private:
+	struct alignas(SIMD_BYTES) State
+	{
+		T x1[Lanes]{}, x2[Lanes]{}, y1[Lanes]{}, y2[Lanes]{};
+	};
+
+	struct Coefficients
+	{
+		T b0, b1, b2, a1, a2;
+		bool operator==(const Coefficients& o) const { return b0 == o.b0 && b1 == o.b1 && b2 == o.b2 && a1 == o.a1 && a2 == o.a2; }
+	};
+
+	int m_Channels = 0;
+	bool m_Started = false;
+	Coefficients m_From[N]{}, m_To[N]{}; // Coefficients at the start and end of the chunk
+	std::vector<std::array<State, N>> m_State;
+	alignas(SIMD_BYTES) T m_Buffer[BlockSize][Lanes];
+
+	/**
+	 * Store the state after a chunk. The output is clamped here instead of every sample
+	 * like BiquadFilter does, a clamp in the inner loop keeps it from being vectorized.
+	 */
+	template<size_t L>
+	static void Store(const T* x1, const T* x2, const T* y1, const T* y2, State& s)
+	{
+		for (size_t l = 0; l < L; l++)
+		{
+			s.x1[l] = x1[l], s.x2[l] = x2[l];
+			s.y1[l] = std::min(std::max(y1[l], (T)-10000000), (T)10000000);
+			s.y2[l] = std::min(std::max(y2[l], (T)-10000000), (T)10000000);
+		}
+	}
+
+	template<size_t L>
+	void ApplyBand(Coefficients from, Coefficients to, State& s, int n)
+	{
+		if (!(from == to))
+			return ApplyBandInterpolated<L>(from, to, s, n);
+
+		const T b0 = to.b0, b1 = to.b1, b2 = to.b2, a1 = to.a1, a2 = to.a2;
+
+		// Local copies so the compiler knows the state doesn't alias the buffer
+		alignas(SIMD_BYTES) T x1[L], x2[L], y1[L], y2[L];
+		std::copy(s.x1, s.x1 + L, x1), std::copy(s.x2, s.x2 + L, x2);
+		std::copy(s.y1, s.y1 + L, y1), std::copy(s.y2, s.y2 + L, y2);
+
+		for (int i = 0; i < n; i++)
+		{
+			T* v = m_Buffer[i];
+			for (size_t l = 0; l < L; l++)
+			{
+				// The feedback of the last output is subtracted last, so only it is on the recursion
+				T x0 = v[l];
+				T y0 = b0 * x0 + b1 * x1[l] + b2 * x2[l] - a2 * y2[l] - a1 * y1[l];
+				x2[l] = x1[l], x1[l] = x0;
+				y2[l] = y1[l], y1[l] = y0;
+				v[l] = y0;
+			}
+		}
+
+		Store<L>(x1, x2, y1, y2, s);
+	}
+
+	template<size_t L>
+	void ApplyBandInterpolated(Coefficients from, Coefficients to, State& s, int n)
+	{
+		const T r = (T)1 / n;
+		const T d0 = (to.b0 - from.b0) * r, d1 = (to.b1 - from.b1) * r, d2 = (to.b2 - from.b2) * r;
+		const T d3 = (to.a1 - from.a1) * r, d4 = (to.a2 - from.a2) * r;
+		T b0 = from.b0, b1 = from.b1, b2 = from.b2, a1 = from.a1, a2 = from.a2;
+
+		alignas(SIMD_BYTES) T x1[L], x2[L], y1[L], y2[L];
+		std::copy(s.x1, s.x1 + L, x1), std::copy(s.x2, s.x2 + L, x2);
+		std::copy(s.y1, s.y1 + L, y1), std::copy(s.y2, s.y2 + L, y2);
+
+		for (int i = 0; i < n; i++)
+		{
+			b0 += d0, b1 += d1, b2 += d2, a1 += d3, a2 += d4;
+			T* v = m_Buffer[i];
+			for (size_t l = 0; l < L; l++)
+			{
+				T x0 = v[l];
+				T y0 = b0 * x0 + b1 * x1[l] + b2 * x2[l] - a2 * y2[l] - a1 * y1[l];
+				x2[l] = x1[l], x1[l] = x0;
+				y2[l] = y1[l], y1[l] = y0;
+				v[l] = y0;
+			}
+		}
+
+		Store<L>(x1, x2, y1, y2, s);
+	}
+};
+
 // Simple low/high pass band filter
 struct SimpleFilterParameters
 {
@@ -279,12 +989,12 @@ struct SimpleFilterParameters
 		double a = from - std::pow(width, 2) + 0.001;
 		m_Params[0].f0 = a < 0 ? -ToFreq(-a) : ToFreq(a);
 		m_Params[0].Q = 0.6;
-		m_Params[0].RecalculateParameters();
+		m_Params[0].Update();
 		m_Params[1].type = FilterType::LowPass;
 		a = from + std::pow(width, 2) - 0.001;
 		m_Params[1].f0 = a < 0 ? -ToFreq(-a) : ToFreq(a);
 		m_Params[1].Q = 0.6;
-		m_Params[1].RecalculateParameters();
+		m_Params[1].Update();
 	}
 
 	double ToFreq(double x)
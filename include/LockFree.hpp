@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Wait-free single producer, single consumer queue with a fixed capacity N, which
+ * must be a power of 2. Push is only called from the producer thread and Pop only
+ * from the consumer thread, neither ever blocks or allocates.
+ */
+template<typename T, size_t N>
+class SPSCQueue
+{
+public:
+	static_assert((N & (N - 1)) == 0, "SPSCQueue capacity must be a power of 2");
+
+	/**
+	 * Add a value, producer thread only.
+	 * @param v value
+	 * @return false when the queue is full
+	 */
+	bool Push(const T& v)
+	{
+		const size_t write = m_Write.load(std::memory_order_relaxed);
+		if (write - m_Read.load(std::memory_order_acquire) == N)
+			return false;
+
+		m_Data[write & (N - 1)] = v;
+		m_Write.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Take the oldest value, consumer thread only.
+	 * @param v receives the value
+	 * @return false when the queue is empty
+	 */
+	bool Pop(T& v)
+	{
+		const size_t read = m_Read.load(std::memory_order_relaxed);
+		if (read == m_Write.load(std::memory_order_acquire))
+			return false;
+
+		v = m_Data[read & (N - 1)];
+		m_Read.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Add as many values as fit, producer thread only.
+	 * @param v values
+	 * @param n amount of values
+	 * @return amount of values added
+	 */
+	size_t Push(const T* v, size_t n)
+	{
+		const size_t write = m_Write.load(std::memory_order_relaxed);
+		n = std::min(n, N - (write - m_Read.load(std::memory_order_acquire)));
+		for (size_t i = 0; i < n; i++)
+			m_Data[(write + i) & (N - 1)] = v[i];
+
+		m_Write.store(write + n, std::memory_order_release);
+		return n;
+	}
+
+	/**
+	 * Take up to n of the oldest values, consumer thread only.
+	 * @param v receives the values
+	 * @param n maximum amount of values
+	 * @return amount of values taken
+	 */
+	size_t Pop(T* v, size_t n)
+	{
+		const size_t read = m_Read.load(std::memory_order_relaxed);
+		n = std::min(n, m_Write.load(std::memory_order_acquire) - read);
+		for (size_t i = 0; i < n; i++)
+			v[i] = m_Data[(read + i) & (N - 1)];
+
+		m_Read.store(read + n, std::memory_order_release);
+		return n;
+	}
+
+	/**
+	 * @return true when there is nothing to pop
+	 */
+	bool Empty() const { return m_Read.load(std::memory_order_acquire) == m_Write.load(std::memory_order_acquire); }
+
+	static constexpr size_t Capacity() { return N; }
+
+private:
+	// Separate cache lines so the threads don't invalidate each other's index
+	alignas(64) std::atomic<size_t> m_Write{ 0 };
+	alignas(64) std::atomic<size_t> m_Read{ 0 };
+	alignas(64) T m_Data[N];
+};
+
+/**
+ * Lock-free triple buffer to publish the newest version of a value from one thread to
+ * another. The producer fills Write() and calls Publish(), the consumer calls Update()
+ * and reads Read(). Neither side ever waits, old unread values are overwritten.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+
+	/**
+	 * Get the buffer to write the next value to, producer thread only.
+	 * @return buffer
+	 */
+	T& Write() { return m_Buffers[m_Back]; }
+
+	/**
+	 * Publish the value in Write(), producer thread only.
+	 */
+	void Publish() { m_Back = m_Middle.exchange(m_Back | Fresh, std::memory_order_acq_rel) & Index; }
+
+	/**
+	 * Take the newest published value if there is one, consumer thread only.
+	 * @return true when Read() changed
+	 */
+	bool Update()
+	{
+		if (!(m_Middle.load(std::memory_order_relaxed) & Fresh))
+			return false;
+
+		m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & Index;
+		return true;
+	}
+
+	/**
+	 * Get the newest value taken by Update(), consumer thread only.
+	 * @return value
+	 */
+	const T& Read() const { return m_Buffers[m_Front]; }
+
+	/**
+	 * Set all three buffers and forget published values, not thread safe. Used
+	 * to size buffers up front so neither thread has to allocate.
+	 * @param v value
+	 */
+	void Initialize(const T& v)
+	{
+		for (auto& b : m_Buffers)
+			b = v;
+		m_Back = 0, m_Middle.store(1), m_Front = 2;
+	}
+
+private:
+	static constexpr int Index = 3;
+	static constexpr int Fresh = 4;
+
+	T m_Buffers[3]{};
+	int m_Back = 0;
+	alignas(64) std::atomic<int> m_Middle{ 1 };
+	alignas(64) int m_Front = 2;
+};
@@ -1,5 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <vector>
+#include "FFT.hpp"
+#include "Filters.hpp"
 
 namespace SoundMixr
 {
@@ -36,6 +42,209 @@ namespace SoundMixr
         double sampleRate = 48000;
     };
 
+    /**
+     * Band-limited wavetable with a table per octave. Level k contains Harmonics >> k
+     * harmonics, so it can be played without aliasing up to a phase increment of
+     * 2^k / (2 * Harmonics) cycles per sample. The shared tables are built on first use.
+     */
+    class BandLimitedWavetable
+    {
+    public:
+        static constexpr int Bits = 12;
+        static constexpr int Size = 1 << Bits;
+        static constexpr int Stride = Size + 1; // Extra sample for interpolation
+        static constexpr int Harmonics = Size / 4;
+        static constexpr int Levels = 11;
+
+        /**
+         * Constructor.
+         * @param harmonic function returning the cosine (real) and sine (imaginary)
+         * amplitude of harmonic h
+         */
+        template<typename Fun>
+        BandLimitedWavetable(Fun harmonic)
+            : m_Data(Levels * Stride)
+        {
+            RealFFT fft(Size);
+            std::vector<std::complex<float>> bins(Size / 2 + 1);
+            for (int k = 0; k < Levels; k++)
+            {
+                std::fill(bins.begin(), bins.end(), std::complex<float>{});
+                for (int h = 1; h <= (Harmonics >> k); h++)
+                {
+                    std::complex<float> a = harmonic(h);
+                    bins[h] = std::complex<float>{ a.real(), -a.imag() } * (Size / 2.0f);
+                }
+
+                float* table = &m_Data[k * Stride];
+                fft.Inverse(bins.data(), table);
+                table[Size] = table[0];
+            }
+        }
+
+        /**
+         * Get the table for a level.
+         * @param k level
+         * @return Stride samples
+         */
+        const float* Level(int k) const { return &m_Data[k * Stride]; }
+
+        /**
+         * Get the level with the most harmonics that doesn't alias.
+         * @param increment phase increment, 2^32 is one cycle
+         * @return level
+         */
+        static int LevelFor(uint32_t increment)
+        {
+            int k = 0;
+            while (k < Levels - 1 && increment > (1u << (33 - Bits + k)))
+                k++;
+            return k;
+        }
+
+        static const BandLimitedWavetable& Sine()
+        {
+            static const BandLimitedWavetable table{ [](int h) { return std::complex<float>{ 0, h == 1 ? 1.0f : 0.0f }; } };
+            return table;
+        }
+
+        static const BandLimitedWavetable& Saw()
+        {
+            static const BandLimitedWavetable table{ [](int h) { return std::complex<float>{ 0, 2.0f / (3.14159265359f * h) }; } };
+            return table;
+        }
+
+        static const BandLimitedWavetable& Square()
+        {
+            static const BandLimitedWavetable table{ [](int h) { return std::complex<float>{ 0, h % 2 ? 4.0f / (3.14159265359f * h) : 0 }; } };
+            return table;
+        }
+
+        static const BandLimitedWavetable& Triangle()
+        {
+            static const BandLimitedWavetable table{ [](int h) { return std::complex<float>{ h % 2 ? 8.0f / (9.8696044f * h * h) : 0, 0 }; } };
+            return table;
+        }
+
+    private:
+        std::vector<float> m_Data;
+    };
+
+    /**
+     * Oscillator playing a BandLimitedWavetable with a 32 bit fixed-point phase
+     * and linear interpolation. The table level is picked when the frequency changes.
+     */
+    class WavetableOscillator
+    {
+    public:
+        static constexpr int FracBits = 32 - BandLimitedWavetable::Bits;
+
+        WavetableOscillator(const BandLimitedWavetable& table = BandLimitedWavetable::Sine())
+            : m_Table(&table)
+        {
+            Update();
+        }
+
+        /**
+         * Set the wavetable.
+         * @param table wavetable
+         */
+        void Wavetable(const BandLimitedWavetable& table) { m_Table = &table; Update(); }
+
+        /**
+         * Set the frequency.
+         * @param f frequency in Hz
+         */
+        void Frequency(double f) { m_Frequency = f; Update(); }
+
+        /**
+         * Get the frequency.
+         * @return frequency in Hz
+         */
+        double Frequency() const { return m_Frequency; }
+
+        /**
+         * Set the samplerate.
+         * @param s samplerate
+         */
+        void SampleRate(double s) { m_SampleRate = s; Update(); }
+
+        /**
+         * Get the samplerate.
+         * @return samplerate
+         */
+        double SampleRate() const { return m_SampleRate; }
+
+        /**
+         * Set the phase.
+         * @param p phase, 0 to 1
+         */
+        void Phase(double p) { m_Phase = (uint32_t)(int64_t)(p * 4294967296.0); }
+
+        /**
+         * Get the phase.
+         * @return phase, 0 to 1
+         */
+        double Phase() const { return m_Phase / 4294967296.0; }
+
+        /**
+         * Generate the next sample.
+         * @return sample
+         */
+        float Process()
+        {
+            float v = Lookup(m_Level, m_Phase);
+            m_Phase += m_Increment;
+            return v;
+        }
+
+        /**
+         * Generate a block of samples.
+         * @param out output buffer
+         * @param n amount of samples
+         */
+        void Render(float* out, int n)
+        {
+            const float* table = m_Level;
+            uint32_t phase = m_Phase, increment = m_Increment;
+            for (int i = 0; i < n; i++, phase += increment)
+                out[i] = Lookup(table, phase);
+            m_Phase = phase;
+        }
+
+        static inline float Lookup(const float* table, uint32_t phase)
+        {
+            uint32_t index = phase >> FracBits;
+            float frac = (phase & ((1u << FracBits) - 1)) * (1.0f / (1u << FracBits));
+            return table[index] + frac * (table[index + 1] - table[index]);
+        }
+
+    private:
+        const BandLimitedWavetable* m_Table;
+        const float* m_Level = nullptr;
+        double m_Frequency = 0;
+        double m_SampleRate = 48000;
+        uint32_t m_Phase = 0;
+        uint32_t m_Increment = 0;
+
+        void Update()
+        {
+            double inc = std::abs(m_Frequency) / m_SampleRate;
+            m_Increment = (uint32_t)(std::min(inc, 0.5) * 4294967296.0);
+            m_Level = m_Table->Level(BandLimitedWavetable::LevelFor(m_Increment));
+        }
+    };
+
+    /**
+     * Frequency of a midi note in equal temperament, A4 (69) at 440 Hz.
+     * @param note midi note
+     * @return frequency in Hz
+     */
+    static inline float NoteToFreq(int note)
+    {
+        return 440.0 * std::pow(2.0, (note - 69) / 12.0);
+    }
+
     class Voice
     {
     public:
@@ -44,8 +253,133 @@ namespace SoundMixr
         virtual void Gate(bool) = 0;
         virtual void Frequency(double) = 0;
         virtual bool Done() = 0;
+
+        /**
+         * Render a block of samples and add them to the output. The default implementation
+         * calls Generate for every sample, override this to render whole blocks at once.
+         * @param out output buffer
+         * @param frames amount of samples
+         */
+        virtual void Render(float* out, int frames)
+        {
+            for (int i = 0; i < frames; i++)
+                out[i] += Generate();
+        }
+    };
+
+    /**
+     * ADSR envelope precalculated as recursive steps, so it can be rendered without
+     * calling pow. Every segment is split in Steps parts, each an exponential
+     * y = y * mul + add fitted through the start, middle and end of the curve, and
+     * resynced to the exact value at its end. For curve parameters between 0.25 and 4
+     * and segments up to 10 seconds this stays within 0.002 of the pow curves.
+     * The release is normalized to start at 1, scale its add by the level it starts at.
+     */
+    class ADSRCurve
+    {
+    public:
+        static constexpr int Steps = 16;
+
+        enum Stage
+        {
+            Attack = 0,
+            Decay = Steps,
+            Sustain = 2 * Steps,
+            Release = 2 * Steps + 1,
+            Done = 3 * Steps + 1
+        };
+
+        struct Step
+        {
+            float mul = 0;  // Multiplier of the previous sample
+            float add = 0;  // Added every sample
+            float end = 0;  // Exact value at the end of the step
+            int length = 0; // Length in samples
+        };
+
+        double a = 0.02, ac = 0.5, d = 0.1, dc = 0.5, s = 0, r = 0.1, rc = 0.5;
+        double sampleRate = 48000;
+
+        ADSRCurve() { RecalculateParameters(); }
+
+        void RecalculateParameters()
+        {
+            Segment(Attack, a, ac, [&](double t) { return std::pow(t, ac); });
+            Segment(Decay, d, dc, [&](double t) { return 1 - (1 - s) * std::pow(t, dc); });
+            Segment(Release, r, rc, [&](double t) { return 1 - std::pow(t, rc); });
+            m_Steps[Sustain] = { 0, (float)s, (float)s, INT_MAX };
+            m_Steps[Done] = { 0, 0, 0, INT_MAX };
+        }
+
+        /**
+         * Get the first step at or after i that isn't empty.
+         * @param i step
+         * @return step
+         */
+        int Next(int i) const
+        {
+            while (m_Steps[i].length == 0)
+                i++;
+            return i;
+        }
+
+        const Step& operator[](int i) const { return m_Steps[i]; }
+
+    private:
+        Step m_Steps[Done + 1];
+
+        template<typename Fun>
+        void Segment(int first, double time, double curve, Fun f)
+        {
+            const int n = (int)std::round(std::max(time, 0.0) * sampleRate);
+
+            // Steps get longer by a power of their index, the curves are steepest at the start.
+            // Curves below 1 are steep enough there to need a higher power.
+            const double q = curve < 1 ? 6 : 3;
+            auto boundary = [&](int i) { return (int)std::round(n * std::pow((double)i / Steps, q)); };
+
+            for (int i = 0; i < Steps; i++)
+            {
+                int k0 = boundary(i), k1 = boundary(i + 1);
+                Step& step = m_Steps[first + i];
+                step.length = k1 - k0;
+                if (step.length == 0)
+                    continue;
+
+                double y0 = f((double)k0 / n), y1 = f((double)k1 / n);
+                double ym = f((k0 + 0.5 * step.length) / n);
+                double d1 = ym - y0, d2 = y1 - ym;
+                step.end = (float)y1;
+
+                // Fit y[j] = A + B * mul^j through j = 0, length / 2 and length,
+                // fall back to a line when the curve doesn't fit an exponential.
+                double ratio = d1 != 0 ? d2 / d1 : 0;
+                double mul = ratio > 0 ? (float)std::pow(ratio, 2.0 / step.length) : 1;
+                if (ratio <= 0 || std::abs(ratio - 1) < 1e-6 || mul == 1)
+                {
+                    step.mul = 1;
+                    step.add = (float)((y1 - y0) / step.length);
+                }
+                else
+                {
+                    // The asymptote is fitted to the rounded multiplier, so a long step
+                    // still ends at y1 instead of drifting by the rounding to the power length
+                    double p = std::pow(mul, step.length);
+                    double A = (y1 - y0 * p) / (1 - p);
+                    step.mul = (float)mul;
+                    step.add = (float)(A * (1 - mul));
+                }
+            }
+        }
     };
 
+    /**
+     * ADSR envelope, rendered with an ADSRCurve that is recalculated when any of the
+     * parameters change. After a change the envelope continues from its current output
+     * value in the step of the new curve at the same phase, so a held note picks up a new
+     * sustain level and a shorter attack skips ahead. See ADSRCurve for how close it
+     * follows the pow curves.
+     */
     class ADSR
     {
     public:
@@ -58,21 +392,70 @@ namespace SoundMixr
         
         virtual float Generate() 
         {
-            if (phase >= 0 && (phase < a + d || !gate)) phase += 1.0 / (double)sampleRate;
-            else if (gate)
-                phase = a + d;
-            if (phase > a + d + r) phase = -1;
-            sample = phase < 0 ? 0 : phase < a ? 
-                std::pow(phase / a, ac) : phase <= a + d ? 
-                1 - (1 - s) * std::pow((phase - a) / d, dc) : phase < a + d + r ? 
-                down - down * std::pow((phase - a - d) / r, rc) : 0;
-            return sample;
+            // Most samples are in the middle of a step
+            if (m_Remaining > 1 && m_Step != ADSRCurve::Done && !Changed())
+            {
+                m_Remaining--;
+                if (m_Step != ADSRCurve::Sustain)
+                    phase += 1.0 / sampleRate;
+                return sample = sample * m_Mul + m_Off;
+            }
+
+            float out;
+            Render(&out, 1);
+            return out;
+        }
+
+        /**
+         * Generate a block of samples.
+         * @param out output buffer
+         * @param n amount of samples
+         */
+        void Render(float* out, int n)
+        {
+            Update();
+            float y = (float)sample;
+            for (int i = 0; i < n;)
+            {
+                if (m_Step == ADSRCurve::Done)
+                {
+                    std::fill(out + i, out + n, 0.0f);
+                    y = 0, phase = -1;
+                    break;
+                }
+
+                const int len = std::min(n - i, m_Remaining);
+                const float mul = m_Mul, off = m_Off;
+                for (int j = 0; j < len; j++)
+                    out[i + j] = y = y * mul + off;
+
+                i += len;
+                m_Remaining -= len;
+                if (m_Step != ADSRCurve::Sustain)
+                    phase += len / sampleRate;
+
+                if (m_Remaining == 0)
+                {
+                    if (m_Step == ADSRCurve::Sustain)
+                        m_Remaining = INT_MAX;
+                    else
+                    {
+                        y = m_Curve[m_Step].end * m_Scale;
+                        Enter(m_Step + 1);
+                    }
+                }
+            }
+            sample = y;
         }
 
         void Trigger()
         {
+            Update();
             down = s;
             phase = 0;
+            sample = 0;
+            m_Scale = 1;
+            Enter(ADSRCurve::Attack);
         }
 
         void Gate(bool g)
@@ -81,6 +464,11 @@ namespace SoundMixr
             {
                 down = sample;
                 phase = a + d;
+                if (m_Step < ADSRCurve::Release)
+                {
+                    m_Scale = down;
+                    Enter(ADSRCurve::Release);
+                }
             }
 
             gate = g;
@@ -90,6 +478,233 @@ namespace SoundMixr
         {
             return phase == -1;
         }
+
+    private:
+        ADSRCurve m_Curve;
+        int m_Step = ADSRCurve::Done;
+        int m_Remaining = INT_MAX;
+        float m_Mul = 0, m_Off = 0, m_Scale = 1;
+
+        void Enter(int step)
+        {
+            step = m_Curve.Next(step);
+
+            // Released before reaching the sustain, continue with the release
+            if (step == ADSRCurve::Sustain && !gate)
+            {
+                m_Scale = down;
+                step = m_Curve.Next(ADSRCurve::Release);
+            }
+
+            if (step == ADSRCurve::Sustain)
+                phase = a + d;
+            else if (step == ADSRCurve::Done)
+                phase = -1;
+
+            const ADSRCurve::Step& st = m_Curve[step];
+            m_Step = step;
+            m_Remaining = st.length;
+            m_Mul = st.mul;
+            m_Off = st.add * m_Scale;
+        }
+
+        /**
+         * Continue in the step of a segment that contains a sample, or in the step after
+         * the segment when it's shorter than that.
+         * @param first first step of the segment
+         * @param samples samples since the start of the segment
+         */
+        void Seek(int first, int samples)
+        {
+            for (int i = first; i < first + ADSRCurve::Steps; i++)
+            {
+                const ADSRCurve::Step& st = m_Curve[i];
+                if (samples < st.length)
+                {
+                    m_Step = i;
+                    m_Remaining = st.length - samples;
+                    m_Mul = st.mul;
+                    m_Off = st.add * m_Scale;
+                    return;
+                }
+                samples -= st.length;
+            }
+
+            Enter(first + ADSRCurve::Steps);
+        }
+
+        bool Changed() const
+        {
+            return m_Curve.a != a || m_Curve.ac != ac || m_Curve.d != d || m_Curve.dc != dc || m_Curve.s != s
+                || m_Curve.r != r || m_Curve.rc != rc || m_Curve.sampleRate != sampleRate;
+        }
+
+        void Update()
+        {
+            if (!Changed())
+                return;
+
+            // Time since the release started, with the old attack and decay
+            const double released = phase - m_Curve.a - m_Curve.d;
+
+            m_Curve.a = a, m_Curve.ac = ac, m_Curve.d = d, m_Curve.dc = dc, m_Curve.s = s;
+            m_Curve.r = r, m_Curve.rc = rc, m_Curve.sampleRate = sampleRate;
+            m_Curve.RecalculateParameters();
+
+            // Re-enter the current stage of the new curve at the same phase
+            if (m_Step < ADSRCurve::Sustain)
+            {
+                if (phase < a)
+                    Seek(ADSRCurve::Attack, (int)(phase * sampleRate));
+                else
+                    Seek(ADSRCurve::Decay, (int)((phase - a) * sampleRate));
+            }
+            else if (m_Step == ADSRCurve::Sustain)
+                Enter(ADSRCurve::Sustain);
+            else if (m_Step < ADSRCurve::Done)
+            {
+                phase = a + d + released;
+                Seek(ADSRCurve::Release, (int)(released * sampleRate));
+            }
+        }
+    };
+
+    /**
+     * Keeps track of which note is playing on which voice. When all voices are
+     * in use, the longest held note is stolen. Pressed voices are kept in an intrusive
+     * list ordered by age and in a list per note, available voices in a ring, so
+     * pressing, stealing and releasing are all constant time.
+     */
+    class VoiceAllocator
+    {
+    public:
+        static constexpr int Notes = 128;
+
+        VoiceAllocator(int voices)
+            : m_Voices(voices), m_Notes(voices, -1), m_Pressed(voices), m_NoteLinks(voices), m_Available(voices)
+        {
+            std::fill(std::begin(m_NoteHeads), std::end(m_NoteHeads), -1);
+
+            // Hand out the highest voice first
+            for (int i = 0; i < voices; i++)
+                m_Available[i] = voices - 1 - i;
+            m_AvailableCount = voices;
+        }
+
+        /**
+         * Assign a voice to a note.
+         * @param note note, 0 to 127
+         * @return voice, or -1 if there are no voices
+         */
+        int Press(int note)
+        {
+            if (note < 0 || note >= Notes || m_Voices == 0)
+                return -1;
+
+            // Release the longest held note
+            if (m_AvailableCount == 0)
+                Free(m_Oldest);
+
+            // Get an available voice
+            int voice = m_Available[m_AvailableFirst];
+            m_AvailableFirst = m_AvailableFirst + 1 == m_Voices ? 0 : m_AvailableFirst + 1;
+            m_AvailableCount--;
+
+            // Newest pressed voice, and first voice playing this note
+            Insert(m_Pressed, m_Newest, m_Oldest, voice);
+            int tail = -1;
+            Insert(m_NoteLinks, m_NoteHeads[note], tail, voice);
+
+            m_Notes[voice] = note;
+            return voice;
+        }
+
+        /**
+         * Release all voices playing a note.
+         * @param note note
+         * @param fun called with each released voice
+         */
+        template<typename Fun>
+        void Release(int note, Fun&& fun)
+        {
+            if (note < 0 || note >= Notes)
+                return;
+
+            while (m_NoteHeads[note] != -1)
+            {
+                int voice = m_NoteHeads[note];
+                fun(voice);
+                Free(voice);
+            }
+        }
+
+        /**
+         * Get the note a voice is playing.
+         * @param voice voice
+         * @return note, or -1 if not pressed
+         */
+        int Note(int voice) const { return m_Notes[voice]; }
+
+        int Voices() const { return m_Voices; }
+
+    private:
+        struct Link
+        {
+            int prev = -1, next = -1;
+        };
+
+        int m_Voices;
+
+        // Current pressed notes per voice
+        std::vector<int> m_Notes;
+
+        // Pressed voices from newest to oldest
+        std::vector<Link> m_Pressed;
+        int m_Newest = -1, m_Oldest = -1;
+
+        // Voices per note
+        std::vector<Link> m_NoteLinks;
+        int m_NoteHeads[Notes];
+
+        // Available voices, oldest released first
+        std::vector<int> m_Available;
+        int m_AvailableFirst = 0, m_AvailableCount = 0;
+
+        void Free(int voice)
+        {
+            int tail = -1;
+            Remove(m_Pressed, m_Newest, m_Oldest, voice);
+            Remove(m_NoteLinks, m_NoteHeads[m_Notes[voice]], tail, voice);
+            m_Notes[voice] = -1;
+
+            int last = m_AvailableFirst + m_AvailableCount;
+            m_Available[last >= m_Voices ? last - m_Voices : last] = voice;
+            m_AvailableCount++;
+        }
+
+        static void Insert(std::vector<Link>& links, int& head, int& tail, int voice)
+        {
+            links[voice] = { -1, head };
+            if (head != -1)
+                links[head].prev = voice;
+            else
+                tail = voice;
+            head = voice;
+        }
+
+        static void Remove(std::vector<Link>& links, int& head, int& tail, int voice)
+        {
+            Link& link = links[voice];
+            if (link.prev != -1)
+                links[link.prev].next = link.next;
+            else
+                head = link.next;
+
+            if (link.next != -1)
+                links[link.next].prev = link.prev;
+            else
+                tail = link.prev;
+        }
     };
 
     template<typename T, typename = std::enable_if_t<std::is_base_of_v<Voice, T>>>
@@ -97,79 +712,74 @@ namespace SoundMixr
     {
     public:
         VoiceBank(int voices)
-            : m_Voices(voices)
+            : m_Voices(voices), m_Allocator(voices), m_ActiveIndex(voices, -1)
         {
-            m_Pressed.reserve(voices);
-            m_Notes.reserve(voices);
+            m_Active.reserve(voices);
             for (int i = 0; i < voices; i++)
-                m_Notes.push_back(-1),
-                m_Available.push_back(i),
                 m_GeneratorVoices.emplace_back();
         }
 
         void NotePress(int note)
         {
-            // Release the longest held note
-            if (m_Available.size() == 0)
-            {
-                int longestheld = m_Pressed.back();
-                m_Pressed.pop_back();
+            int voice = m_Allocator.Press(note);
+            if (voice == -1)
+                return;
 
-                // Set note to -1 and emplace to available.
-                m_Notes[longestheld] = -1;
-                m_Available.emplace(m_Available.begin(), longestheld);
-            }
+            m_GeneratorVoices[voice].Frequency(NoteToFreq(note));
+            m_GeneratorVoices[voice].Trigger();
+            m_GeneratorVoices[voice].Gate(true);
 
-            // Get an available voice
-            if (!m_Available.empty())
-            {
-                int voice = m_Available.back();
-                m_Available.pop_back();
-
-                // Emplace it to pressed voices queue
-                m_Pressed.emplace(m_Pressed.begin(), voice);
-
-                // Set voice to note
-                m_Notes[voice] = note;
-                m_GeneratorVoices[voice].Frequency(NoteToFreq(note));
-                m_GeneratorVoices[voice].Trigger();
-                m_GeneratorVoices[voice].Gate(true);
-            }
+            if (m_ActiveIndex[voice] == -1)
+                m_ActiveIndex[voice] = static_cast<int>(m_Active.size()),
+                m_Active.push_back(voice);
         }
 
         void NoteRelease(int note)
         {
-            // Find the note in the pressed notes per voice
-            while (true)
+            m_Allocator.Release(note, [&](int voice) { m_GeneratorVoices[voice].Gate(false); });
+        }
+
+        float Generate()
+        {
+            float out = 0;
+            for (size_t i = 0; i < m_Active.size();)
             {
-                auto& it = std::find(m_Notes.begin(), m_Notes.end(), note);
-                if (it != m_Notes.end())
+                int voice = m_Active[i];
+                if (m_GeneratorVoices[voice].Done())
                 {
-                    // If it was pressed, get the voice index
-                    int voice = std::distance(m_Notes.begin(), it);
-
-                    // Set note to -1 and emplace to available.
-                    m_GeneratorVoices[voice].Gate(false);
-                    m_Notes[voice] = -1;
-                    m_Available.emplace(m_Available.begin(), voice);
-
-                    // Erase it from the pressed queue
-                    auto& it2 = std::find(m_Pressed.begin(), m_Pressed.end(), voice);
-                    if (it2 != m_Pressed.end())
-                        m_Pressed.erase(it2);
+                    Deactivate(i);
+                    continue;
                 }
-                else break;
+
+                out += m_GeneratorVoices[voice].Generate();
+                i++;
             }
+
+            return out;
         }
 
-        float Generate()
+        /**
+         * Generate a block of samples, useful inside GeneratorBase::Render. Every active
+         * voice renders the whole block with Voice::Render, voices that are done are
+         * removed once per block.
+         * @param out output buffer
+         * @param frames amount of samples
+         */
+        void Generate(float* out, int frames)
         {
-            float out = 0;
-            for (int i = 0; i < m_Voices; i++)
-                if (!m_GeneratorVoices[i].Done())
-                    out += m_GeneratorVoices[i].Generate();
+            std::fill(out, out + frames, 0.0f);
+            for (size_t i = 0; i < m_Active.size();)
+            {
+                int voice = m_Active[i];
+                if (m_GeneratorVoices[voice].Done())
+                {
+                    Deactivate(i);
+                    continue;
+                }
 
-            return out;
+                m_GeneratorVoices[voice].Render(out, frames);
+                i++;
+            }
         }
 
         std::vector<T>& Voices()
@@ -177,24 +787,307 @@ namespace SoundMixr
             return m_GeneratorVoices;
         }
     
-        static inline float NoteToFreq(int note)
-        {
-            return 440.0 * std::pow(2.0, (note - 69) / 12.0);
-        }
+        static inline float NoteToFreq(int note) { return SoundMixr::NoteToFreq(note); }
     
     private:
         int m_Voices;
         std::vector<T> m_GeneratorVoices;
-    
-        // Current pressed notes per voice
-        std::vector<int> m_Notes;
+        VoiceAllocator m_Allocator;
 
-        // Queue to track longest held note
-        std::vector<int> m_Pressed;
+        // Voices that aren't done, and their index in that list
+        std::vector<int> m_Active;
+        std::vector<int> m_ActiveIndex;
 
-        // Available voices
-        std::vector<int> m_Available;
+        void Deactivate(size_t i)
+        {
+            // Swap with the last active voice
+            int voice = m_Active[i];
+            m_ActiveIndex[m_Active.back()] = static_cast<int>(i);
+            m_Active[i] = m_Active.back();
+            m_Active.pop_back();
+            m_ActiveIndex[voice] = -1;
+        }
+    };
+
+    /**
+     * Wavetable voices with an ADSRCurve envelope, stored as structure of arrays in
+     * groups of Lanes voices so each group renders with SIMD. The lanes of a group are
+     * rendered in chunks that end at the first envelope step change, so the inner loop
+     * has no branches. Groups without active voices are skipped.
+     */
+    class VoiceLanes
+    {
+    public:
+        static constexpr size_t Lanes = SIMD_BYTES / sizeof(float);
+        static constexpr int BlockSize = 64;
+        static constexpr int FracBits = WavetableOscillator::FracBits;
+
+        ADSRCurve envelope;
+
+        /**
+         * Constructor.
+         * @param voices amount of voices, rounded up to a multiple of Lanes
+         * @param table wavetable
+         */
+        VoiceLanes(int voices, const BandLimitedWavetable& table = BandLimitedWavetable::Saw())
+            : m_Groups((voices + Lanes - 1) / Lanes), m_Table(&table)
+        {
+            for (auto& g : m_Groups)
+                for (size_t l = 0; l < Lanes; l++)
+                    g.step[l] = ADSRCurve::Done, g.remaining[l] = INT_MAX;
+        }
+
+        /**
+         * Set the wavetable.
+         * @param table wavetable
+         */
+        void Wavetable(const BandLimitedWavetable& table) { m_Table = &table; }
+
+        /**
+         * Set the samplerate, also recalculates the envelope.
+         * @param s samplerate
+         */
+        void SampleRate(double s)
+        {
+            m_SampleRate = s;
+            envelope.sampleRate = s;
+            envelope.RecalculateParameters();
+        }
+
+        /**
+         * Set the frequency of a voice.
+         * @param voice voice
+         * @param f frequency in Hz
+         */
+        void Frequency(int voice, double f)
+        {
+            Group& g = m_Groups[voice / Lanes];
+            const size_t l = voice % Lanes;
+            double inc = std::abs(f) / m_SampleRate;
+            g.inc[l] = (uint32_t)(std::min(inc, 0.5) * 4294967296.0);
+            g.level[l] = BandLimitedWavetable::LevelFor(g.inc[l]) * BandLimitedWavetable::Stride;
+        }
+
+        /**
+         * Restart the envelope of a voice.
+         * @param voice voice
+         */
+        void Trigger(int voice)
+        {
+            Group& g = m_Groups[voice / Lanes];
+            const size_t l = voice % Lanes;
+            g.env[l] = 0;
+            g.scale[l] = 1;
+            Enter(g, l, ADSRCurve::Attack);
+        }
+
+        /**
+         * Release the envelope of a voice.
+         * @param voice voice
+         */
+        void Release(int voice)
+        {
+            Group& g = m_Groups[voice / Lanes];
+            const size_t l = voice % Lanes;
+            if (g.step[l] >= ADSRCurve::Release)
+                return;
+
+            g.scale[l] = g.env[l];
+            Enter(g, l, ADSRCurve::Release);
+        }
 
+        /**
+         * @param voice voice
+         * @return true when the envelope of the voice has ended
+         */
+        bool Done(int voice) const { return m_Groups[voice / Lanes].step[voice % Lanes] == ADSRCurve::Done; }
+
+        /**
+         * Render the sum of all voices.
+         * @param out output buffer
+         * @param frames amount of samples
+         */
+        void Render(float* out, int frames)
+        {
+            while (frames > 0)
+            {
+                int n = std::min(frames, BlockSize);
+                for (auto& g : m_Groups)
+                    if (g.active)
+                        Render(g, n);
+
+                for (int i = 0; i < n; i++)
+                {
+                    float sum = 0;
+                    for (size_t l = 0; l < Lanes; l++)
+                        sum += m_Mix[i][l], m_Mix[i][l] = 0;
+                    out[i] = sum;
+                }
+
+                out += n, frames -= n;
+            }
+        }
+
+    private:
+        struct alignas(SIMD_BYTES) Group
+        {
+            uint32_t phase[Lanes]{};
+            uint32_t inc[Lanes]{};
+            uint32_t level[Lanes]{}; // Offset of the table level
+            float env[Lanes]{};
+            float mul[Lanes]{};
+            float off[Lanes]{};      // Step add times scale
+            float scale[Lanes]{};    // Level the release started at
+            int remaining[Lanes]{};  // Samples left in the step
+            int step[Lanes]{};
+            int active = 0;
+        };
+
+        std::vector<Group> m_Groups;
+        const BandLimitedWavetable* m_Table;
+        double m_SampleRate = 48000;
+        alignas(SIMD_BYTES) float m_Mix[BlockSize][Lanes]{};
+
+        void Enter(Group& g, size_t l, int step)
+        {
+            step = envelope.Next(step);
+            const ADSRCurve::Step& s = envelope[step];
+            g.active += (step != ADSRCurve::Done) - (g.step[l] != ADSRCurve::Done);
+            g.step[l] = step;
+            g.remaining[l] = s.length;
+            g.mul[l] = s.mul;
+            g.off[l] = s.add * g.scale[l];
+        }
+
+        static inline float Sample(const float* table, uint32_t& phase, uint32_t inc, uint32_t level, float& env, float mul, float off)
+        {
+            env = env * mul + off;
+            const uint32_t index = level + (phase >> FracBits);
+            const float frac = (phase & ((1u << FracBits) - 1)) * (1.0f / (1u << FracBits));
+            const float a = table[index], b = table[index + 1];
+            phase += inc;
+            return (a + frac * (b - a)) * env;
+        }
 
+        void Render(Group& g, int frames)
+        {
+            const float* table = m_Table->Level(0);
+            alignas(SIMD_BYTES) uint32_t phase[Lanes], inc[Lanes], level[Lanes];
+            alignas(SIMD_BYTES) float env[Lanes], mul[Lanes], off[Lanes];
+            std::copy(g.phase, g.phase + Lanes, phase);
+            std::copy(g.inc, g.inc + Lanes, inc);
+            std::copy(g.level, g.level + Lanes, level);
+            std::copy(g.env, g.env + Lanes, env);
+            std::copy(g.mul, g.mul + Lanes, mul);
+            std::copy(g.off, g.off + Lanes, off);
+
+            for (int i = 0; i < frames && g.active;)
+            {
+                int n = frames - i;
+                for (size_t l = 0; l < Lanes; l++)
+                    n = std::min(n, g.remaining[l]);
+
+                // Lanes that are done are skipped, unless all lanes are playing
+                size_t playing[Lanes], count = 0;
+                for (size_t l = 0; l < Lanes; l++)
+                    if (g.step[l] != ADSRCurve::Done)
+                        playing[count++] = l;
+
+                if (count == Lanes)
+                    for (int j = 0; j < n; j++)
+                    {
+                        float* mix = m_Mix[i + j];
+                        for (size_t l = 0; l < Lanes; l++)
+                            mix[l] += Sample(table, phase[l], inc[l], level[l], env[l], mul[l], off[l]);
+                    }
+                else
+                    for (int j = 0; j < n; j++)
+                    {
+                        float* mix = m_Mix[i + j];
+                        for (size_t k = 0; k < count; k++)
+                        {
+                            const size_t l = playing[k];
+                            mix[l] += Sample(table, phase[l], inc[l], level[l], env[l], mul[l], off[l]);
+                        }
+                    }
+
+                // Move lanes that finished their step to the next one
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    g.remaining[l] -= n;
+                    if (g.remaining[l] > 0)
+                        continue;
+
+                    const int step = g.step[l];
+                    if (step == ADSRCurve::Sustain || step == ADSRCurve::Done)
+                    {
+                        g.remaining[l] = INT_MAX;
+                        continue;
+                    }
+
+                    env[l] = envelope[step].end * g.scale[l];
+                    Enter(g, l, step + 1);
+                    mul[l] = g.mul[l], off[l] = g.off[l];
+                }
+
+                i += n;
+            }
+
+            std::copy(phase, phase + Lanes, g.phase);
+            std::copy(env, env + Lanes, g.env);
+        }
+    };
+
+    /**
+     * VoiceBank rendering VoiceLanes, for large amounts of voices.
+     */
+    class LaneVoiceBank
+    {
+    public:
+        LaneVoiceBank(int voices, const BandLimitedWavetable& table = BandLimitedWavetable::Saw())
+            : m_Lanes(voices, table), m_Allocator(voices)
+        {}
+
+        void NotePress(int note)
+        {
+            int voice = m_Allocator.Press(note);
+            if (voice == -1)
+                return;
+
+            m_Lanes.Frequency(voice, NoteToFreq(note));
+            m_Lanes.Trigger(voice);
+        }
+
+        void NoteRelease(int note)
+        {
+            m_Allocator.Release(note, [&](int voice) { m_Lanes.Release(voice); });
+        }
+
+        float Generate()
+        {
+            float out;
+            m_Lanes.Render(&out, 1);
+            return out;
+        }
+
+        /**
+         * Generate a block of samples, useful inside GeneratorBase::Render.
+         * @param out output buffer
+         * @param frames amount of samples
+         */
+        void Generate(float* out, int frames)
+        {
+            m_Lanes.Render(out, frames);
+        }
+
+        /**
+         * Get the voice lanes, to set the wavetable, samplerate and envelope.
+         * Call envelope.RecalculateParameters() after changing the envelope.
+         */
+        VoiceLanes& Lanes() { return m_Lanes; }
+
+    private:
+        VoiceLanes m_Lanes;
+        VoiceAllocator m_Allocator;
     };
- }
\ No newline at end of file
+ }
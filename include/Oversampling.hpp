@@ -0,0 +1,206 @@
+#pragma once
+#include "Filters.hpp"
+
+/**
+ * Polyphase branch of a Kaiser-Bessel half-band lowpass with M taps. A half-band filter
+ * has a centre tap of 0.5 and every other tap zero, so only the (M + 1) / 2 nonzero taps
+ * at odd distance from the centre are stored, multiplied by 2.
+ */
+template<size_t M, typename T = float>
+class HalfBandParameters : public FIRFilterParameters<(M + 1) / 2, T>
+{
+public:
+	static_assert(M % 4 == 3 && M >= 7, "A half-band filter needs 4k + 3 taps, at least 7");
+
+	double attenuation = 80; // Stopband attenuation in dB
+
+	void RecalculateParameters()
+	{
+		// Cutoff at a quarter of the samplerate makes every even offset from the centre zero
+		KaiserBesselParameters<M> kaiser;
+		kaiser.sampleRate = 4, kaiser.Fa = 0, kaiser.Fb = 1;
+		kaiser.attenuation = attenuation;
+		kaiser.RecalculateParameters();
+
+		for (size_t k = 0; k < (M + 1) / 2; k++)
+			this->H[k] = 2 * kaiser.H[2 * k];
+	}
+};
+
+/**
+ * Runs a process at 2x, 4x or 8x the samplerate using cascaded polyphase half-band stages.
+ * Upsampling only filters the input samples, not the zeros stuffed in between; downsampling
+ * only calculates the samples that are kept. Both halves of each stage are the nonzero
+ * branch (a DirectFIRFilter) plus a pure delay for the centre tap.
+ */
+template<size_t M = 63>
+class Oversampler
+{
+public:
+	static constexpr int MaxFactor = 8;
+	static constexpr int BlockSize = 64;
+
+	/**
+	 * Constructor.
+	 * @param factor oversampling factor, 1, 2, 4 or 8
+	 * @param attenuation stopband attenuation of the half-band filters in dB
+	 */
+	Oversampler(int factor = 2, double attenuation = 80)
+	{
+		m_Params.attenuation = attenuation;
+		m_Params.RecalculateParameters();
+		Factor(factor);
+	}
+
+	/**
+	 * Set the oversampling factor, resets the filters.
+	 * @param f factor, 1, 2, 4 or 8
+	 */
+	void Factor(int f)
+	{
+		m_Stages = 0;
+		while ((2 << m_Stages) <= std::min(f, MaxFactor))
+			m_Stages++;
+		Reset();
+	}
+
+	/**
+	 * Get the oversampling factor.
+	 * @return factor
+	 */
+	int Factor() const { return 1 << m_Stages; }
+
+	/**
+	 * Latency in samples at the base samplerate added by up- and downsampling.
+	 * This is fractional for factors above 2.
+	 */
+	double Latency() const
+	{
+		double latency = 0;
+		for (int s = 1; s <= m_Stages; s++)
+			latency += 2.0 * C / (1 << s);
+		return latency;
+	}
+
+	/**
+	 * Clear all filter state.
+	 */
+	void Reset()
+	{
+		for (auto& s : m_Up)
+			s = UpStage{};
+		for (auto& s : m_Down)
+			s = DownStage{};
+	}
+
+	/**
+	 * Process a block, the oversampled block is passed to fun as (float* data, int n)
+	 * to be processed in place. Long blocks are split in chunks of BlockSize samples.
+	 * @param in input samples
+	 * @param out output samples, may be the same as in
+	 * @param frames amount of samples
+	 * @param fun oversampled process
+	 */
+	template<typename Fun>
+	void Process(const float* in, float* out, int frames, Fun&& fun)
+	{
+		while (frames > 0)
+		{
+			int n = std::min(frames, BlockSize);
+			float* a = m_Buffer[0];
+			float* b = m_Buffer[1];
+			std::copy(in, in + n, a);
+
+			for (int s = 0; s < m_Stages; s++, n *= 2)
+				m_Up[s].Process(a, b, n, m_Params), std::swap(a, b);
+
+			fun(a, n);
+
+			for (int s = m_Stages - 1; s >= 0; s--)
+				n /= 2, m_Down[s].Process(a, b, n, m_Params), std::swap(a, b);
+
+			std::copy(a, a + n, out);
+			in += n, out += n, frames -= n;
+		}
+	}
+
+	/**
+	 * Process a single sample, fun is called Factor() times as (float) -> float.
+	 * @param in sample
+	 * @param fun oversampled process
+	 * @return sample
+	 */
+	template<typename Fun>
+	float Process(float in, Fun&& fun)
+	{
+		float out;
+		Process(&in, &out, 1, [&](float* data, int n) {
+			for (int i = 0; i < n; i++)
+				data[i] = fun(data[i]);
+		});
+		return out;
+	}
+
+private:
+	static constexpr size_t N = (M + 1) / 2; // Nonzero taps
+	static constexpr size_t C = (M - 1) / 2; // Centre tap, delay of a stage
+	using Params = HalfBandParameters<M>;
+	using Branch = DirectFIRFilter<N, Params>;
+
+	/**
+	 * Even outputs are the filtered input, odd outputs the input delayed to the centre tap.
+	 */
+	struct UpStage
+	{
+		static constexpr size_t D = (C - 1) / 2;
+		Branch fir;
+		float delay[D]{};
+		size_t pos = 0;
+		float temp[BlockSize * MaxFactor / 2];
+
+		void Process(const float* in, float* out, int n, Params& p)
+		{
+			fir.Apply(in, temp, n, p);
+			for (int j = 0; j < n; j++)
+			{
+				out[2 * j] = temp[j];
+				out[2 * j + 1] = delay[pos];
+				delay[pos] = in[j];
+				pos = pos + 1 == D ? 0 : pos + 1;
+			}
+		}
+	};
+
+	/**
+	 * Filters the even inputs and adds the odd inputs delayed to the centre tap.
+	 */
+	struct DownStage
+	{
+		static constexpr size_t D = (C + 1) / 2;
+		Branch fir;
+		float delay[D]{};
+		size_t pos = 0;
+		float even[BlockSize * MaxFactor / 2];
+
+		void Process(const float* in, float* out, int n, Params& p)
+		{
+			for (int j = 0; j < n; j++)
+				even[j] = in[2 * j];
+
+			fir.Apply(even, even, n, p);
+			for (int j = 0; j < n; j++)
+			{
+				float odd = in[2 * j + 1];
+				out[j] = 0.5f * (even[j] + delay[pos]);
+				delay[pos] = odd;
+				pos = pos + 1 == D ? 0 : pos + 1;
+			}
+		}
+	};
+
+	Params m_Params;
+	int m_Stages = 0;
+	UpStage m_Up[3];
+	DownStage m_Down[3];
+	float m_Buffer[2][BlockSize * MaxFactor];
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+// The headers target MSVC, this lets the tests and benchmarks build with GCC and Clang too
+#ifndef _MSC_VER
+#include <cmath>
+#include <math.h>
+namespace std { using ::powf; using ::log10f; }
+#define __declspec(x)
+#define __cdecl
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include "Compat.hpp"
+#include <cmath>
+#include <cstdio>
+
+/**
+ * Minimal checks for the tests, a failed check prints its location and
+ * makes the test return a nonzero exit code.
+ */
+inline int& Failures() { static int failures = 0; return failures; }
+
+#define CHECK(x) do { if (!(x)) { \
+	std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); Failures()++; } } while (0)
+
+#define CHECK_NEAR(a, b, eps) do { const double _a = (a), _b = (b); if (!(std::abs(_a - _b) <= (eps))) { \
+	std::printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #a, #b, _a, _b); Failures()++; } } while (0)
+
+inline int TestResult()
+{
+	if (Failures())
+		std::printf("%d check(s) failed\n", Failures());
+	return Failures() ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Compat.hpp"
+#include <chrono>
+#include <cstdio>
+
+/**
+ * Time a function, runs it once to warm up and then reports the fastest of a few runs.
+ * @param fun function to time
+ * @param runs amount of timed runs
+ * @return seconds
+ */
+template<typename Fun>
+double Time(Fun&& fun, int runs = 5)
+{
+	fun();
+	double best = 1e30;
+	for (int r = 0; r < runs; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fun();
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+		best = d.count() < best ? d.count() : best;
+	}
+	return best;
+}
+
+// Keeps the compiler from optimizing a result away
+template<typename T>
+void Use(const T& v)
+{
+#ifdef _MSC_VER
+	static volatile T sink;
+	sink = v;
+	(void)sink;
+#else
+	asm volatile("" : : "r,m"(v) : "memory");
+#endif
+}
@@ -0,0 +1,59 @@
+#include "Bench.hpp"
+#include "Compressor.hpp"
+#include <vector>
+
+constexpr int ChannelCount = 2;
+constexpr int Frames = 20 * 48000;
+constexpr int BlockSize = 512;
+
+template<typename Fun>
+double Run(Fun process)
+{
+	std::vector<std::vector<float>> buffers(ChannelCount, std::vector<float>(Frames));
+	for (int c = 0; c < ChannelCount; c++)
+		for (int i = 0; i < Frames; i++)
+			buffers[c][i] = std::sin(i * (0.01f + 0.003f * c)) * (i % 48000 < 24000 ? 0.9f : 0.05f);
+
+	std::vector<float*> io;
+	for (auto& b : buffers)
+		io.push_back(b.data());
+
+	return Time([&] {
+		float* ptrs[ChannelCount];
+		for (int i = 0; i < Frames; i += BlockSize)
+		{
+			for (int c = 0; c < ChannelCount; c++)
+				ptrs[c] = io[c] + i;
+			process(ptrs, std::min(BlockSize, Frames - i));
+		}
+		Use(buffers[0][0]);
+	});
+}
+
+void Setup(Compressor& c)
+{
+	c.pregain = 1, c.postgain = 1, c.mix = 1;
+	c.compressThreshhold = -20, c.expanderThreshhold = -60;
+	c.Attack(5), c.Release(50);
+}
+
+int main()
+{
+	Compressor single;
+	Setup(single);
+	single.Channels(ChannelCount);
+	double one = Run([&](float* const* io, int n) { single.Process(io, io, ChannelCount, n); });
+
+	std::printf("20 s of stereo at 48 kHz, ms\n");
+	std::printf("Compressor:                  %7.2f\n", one * 1000);
+	for (int bands = 2; bands <= MultibandCompressor::MaxBands; bands++)
+	{
+		MultibandCompressor multiband;
+		multiband.Bands(bands);
+		for (auto& b : multiband.bands)
+			Setup(b);
+		multiband.Channels(ChannelCount);
+		double t = Run([&](float* const* io, int n) { multiband.Process(io, io, ChannelCount, n); });
+		std::printf("MultibandCompressor %d bands: %7.2f (%.1fx, %.1fx per band)\n", bands, t * 1000, t / one, t / one / bands);
+	}
+}
@@ -0,0 +1,51 @@
+#include "Bench.hpp"
+#include "Filters.hpp"
+#include <vector>
+
+constexpr int Frames = 48000;
+constexpr int BlockSize = 512;
+
+/**
+ * Cost per sample of a filter with M taps, processed in blocks.
+ */
+template<size_t M, template<size_t, typename> class F>
+double Run()
+{
+	using Params = KaiserBesselParameters<M, float>;
+	Params p;
+	p.Fa = 100, p.Fb = 5000;
+	p.RecalculateParameters();
+	F<M, Params> filter;
+	std::vector<float> buffer(Frames), out(Frames);
+	for (int i = 0; i < Frames; i++)
+		buffer[i] = (i * 7919 % 200) / 100.0f - 1;
+
+	return Time([&] {
+		for (int i = 0; i < Frames; i += BlockSize)
+			filter.Apply(buffer.data() + i, out.data() + i, std::min(BlockSize, Frames - i), p);
+		Use(out[0]);
+	}) / Frames * 1e9;
+}
+
+template<size_t M, typename P>
+using Convolution = ConvolutionFIRFilter<M, P>;
+
+template<size_t M>
+void Compare()
+{
+	double direct = Run<M, DirectFIRFilter>();
+	double convolution = Run<M, Convolution>();
+	std::printf("%6zu taps: direct %8.2f ns/sample, convolution %6.2f ns/sample (%.2fx)\n",
+		M, direct, convolution, direct / convolution);
+}
+
+int main()
+{
+	Compare<64>();
+	Compare<128>();
+	Compare<256>();
+	Compare<512>();
+	Compare<1024>();
+	Compare<4096>();
+	Compare<16384>();
+}
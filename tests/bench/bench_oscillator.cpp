@@ -0,0 +1,42 @@
+#include "Bench.hpp"
+#include "Oscillator.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr int Frames = 480000;
+constexpr int BlockSize = 256;
+
+int main()
+{
+	std::vector<float> out(Frames);
+	std::printf("Saw at 440 Hz, %d samples\n", Frames);
+
+	double naive = Time([&] {
+		Oscillator osc;
+		osc.wavetable = Wavetables::Saw, osc.frequency = 440;
+		for (int i = 0; i < Frames; i++)
+			out[i] = osc.Process();
+		Use(out[Frames - 1]);
+	});
+
+	double process = Time([&] {
+		WavetableOscillator osc{ BandLimitedWavetable::Saw() };
+		osc.Frequency(440);
+		for (int i = 0; i < Frames; i++)
+			out[i] = osc.Process();
+		Use(out[Frames - 1]);
+	});
+
+	double render = Time([&] {
+		WavetableOscillator osc{ BandLimitedWavetable::Saw() };
+		osc.Frequency(440);
+		for (int i = 0; i < Frames; i += BlockSize)
+			osc.Render(&out[i], std::min(BlockSize, Frames - i));
+		Use(out[Frames - 1]);
+	});
+
+	std::printf("  Oscillator (aliasing):       %6.2f ns/sample\n", naive / Frames * 1e9);
+	std::printf("  WavetableOscillator Process: %6.2f ns/sample (%.1fx)\n", process / Frames * 1e9, naive / process);
+	std::printf("  WavetableOscillator Render:  %6.2f ns/sample (%.1fx)\n", render / Frames * 1e9, naive / render);
+}
@@ -0,0 +1,101 @@
+#include "Bench.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr int ChannelCount = 64;
+constexpr int Frames = 512;
+constexpr int Blocks = 94; // About 1 second at 48 kHz
+
+/**
+ * Peaking EQ through the per-sample Process path.
+ */
+class PerSample : public EffectBase
+{
+public:
+	PerSample() : EffectBase("PerSample")
+	{
+		m_Params.type = FilterType::PeakingEQ, m_Params.f0 = 1000, m_Params.Q = 1, m_Params.dbgain = 6;
+		m_Params.RecalculateParameters();
+	}
+
+	float Process(float in, int c) override { return m_Filters[c].Apply(in, m_Params); }
+
+protected:
+	BiquadParameters m_Params;
+	BiquadFilter<> m_Filters[ChannelCount];
+};
+
+/**
+ * Same filter, overriding ProcessBlock to filter each channel as a block.
+ */
+class PerBlock : public PerSample
+{
+public:
+	void ProcessBlock(const float* const* in, float* const* out, int channels, int frames) override
+	{
+		for (int c = 0; c < channels; c++)
+			m_Filters[c].Apply(in[c], out[c], frames, m_Params);
+	}
+};
+
+/**
+ * Same filter, running all channels at once in SIMD lanes with a MultiChannelEqualizer.
+ */
+template<typename T>
+class PerBlockLanes : public EffectBase
+{
+public:
+	PerBlockLanes() : EffectBase("PerBlockLanes"), m_Equalizer(m_Params)
+	{
+		m_Params.resize(1);
+		m_Params[0].type = FilterType::PeakingEQ, m_Params[0].f0 = 1000, m_Params[0].Q = 1, m_Params[0].dbgain = 6;
+		m_Params[0].RecalculateParameters();
+		m_Equalizer.Channels(ChannelCount);
+	}
+
+	float Process(float in, int) override { return in; }
+
+	void ProcessBlock(const float* const* in, float* const* out, int channels, int frames) override
+	{
+		m_Equalizer.Apply(in, out, channels, frames);
+	}
+
+private:
+	std::vector<BiquadParameters> m_Params;
+	MultiChannelEqualizer<1, T> m_Equalizer;
+};
+
+template<typename Effect>
+double Run()
+{
+	Effect effect;
+	std::vector<std::vector<float>> buffers(ChannelCount, std::vector<float>(Frames));
+	std::vector<float*> io;
+	for (auto& b : buffers)
+		io.push_back(b.data());
+
+	return Time([&] {
+		for (int b = 0; b < Blocks; b++)
+		{
+			for (auto& buffer : buffers)
+				for (int i = 0; i < Frames; i++)
+					buffer[i] = (i % 64) / 64.f - 0.5f;
+			effect.ProcessBlock(io.data(), io.data(), ChannelCount, Frames);
+		}
+		Use(buffers[0][0]);
+	});
+}
+
+int main()
+{
+	const double samples = double(ChannelCount) * Frames * Blocks;
+	const double sample = Run<PerSample>(), block = Run<PerBlock>();
+	const double lanes = Run<PerBlockLanes<double>>(), floatLanes = Run<PerBlockLanes<float>>();
+	std::printf("BiquadFilter, %d channels x %d frames\n", ChannelCount, Frames);
+	std::printf("  per-sample Process: %7.2f ns/sample\n", sample / samples * 1e9);
+	std::printf("  per-block  Apply:   %7.2f ns/sample (%.1fx)\n", block / samples * 1e9, sample / block);
+	std::printf("  per-block  lanes:   %7.2f ns/sample (%.1fx)\n", lanes / samples * 1e9, sample / lanes);
+	std::printf("  float lanes:        %7.2f ns/sample (%.1fx)\n", floatLanes / samples * 1e9, sample / floatLanes);
+}
@@ -0,0 +1,67 @@
+#include "Bench.hpp"
+#include "Base.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr int Instances = 1000;
+
+/**
+ * A channel strip sized plugin, 16 knobs, a dropdown, 2 toggles and a dynamics slider.
+ */
+class Strip : public EffectBase
+{
+public:
+	Strip()
+		: EffectBase("Strip")
+	{
+		for (int i = 0; i < 16; i++)
+			Parameter("Knob " + std::to_string(i), ParameterType::Knob).Value(0.1 * i);
+
+		auto& mode = DropDown("Mode");
+		mode.AddOption("A", 0), mode.AddOption("B", 1), mode.Select(1);
+		Toggle("Bypass").State(true), Toggle("Solo");
+		DynamicsSlider().CompressorThreshhold(-20);
+	}
+
+	using EffectBase::operator=;
+
+	float Process(float in, int) override { return in; }
+};
+
+int main()
+{
+	std::vector<std::unique_ptr<Strip>> strips;
+	for (int i = 0; i < Instances; i++)
+		strips.push_back(std::make_unique<Strip>());
+
+	std::vector<std::string> json(Instances);
+	const double jsonSave = Time([&] {
+		for (int i = 0; i < Instances; i++)
+			json[i] = static_cast<nlohmann::json>(*strips[i]).dump();
+	});
+
+	const double jsonLoad = Time([&] {
+		for (int i = 0; i < Instances; i++)
+			*strips[i] = nlohmann::json::parse(json[i]);
+	});
+
+	// One buffer for the whole session, like a host state chunk
+	const size_t size = strips[0]->StateSize();
+	std::vector<uint8_t> data(size * Instances);
+	const double binarySave = Time([&] {
+		for (int i = 0; i < Instances; i++)
+			Use(strips[i]->Save(&data[i * size], size));
+	});
+
+	const double binaryLoad = Time([&] {
+		for (int i = 0; i < Instances; i++)
+			Use(strips[i]->Load(&data[i * size], size));
+	});
+
+	std::printf("%d instances, %zu bytes binary, %zu bytes json each, ms\n", Instances, size, json[0].size());
+	std::printf("save: json %7.2f, binary %7.2f (%.0fx)\n", jsonSave * 1000, binarySave * 1000, jsonSave / binarySave);
+	std::printf("load: json %7.2f, binary %7.2f (%.0fx)\n", jsonLoad * 1000, binaryLoad * 1000, jsonLoad / binaryLoad);
+}
@@ -0,0 +1,207 @@
+#include "Bench.hpp"
+#include "Oscillator.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr int Events = 1000000;
+
+/**
+ * The vector based allocator from before VoiceAllocator became constant time,
+ * kept here as a reference.
+ */
+class LinearAllocator
+{
+public:
+	LinearAllocator(int voices)
+	{
+		for (int i = 0; i < voices; i++)
+			m_Notes.push_back(-1), m_Available.push_back(i);
+	}
+
+	int Press(int note)
+	{
+		if (m_Available.empty() && !m_Pressed.empty())
+		{
+			int longestheld = m_Pressed.back();
+			m_Pressed.pop_back();
+			m_Notes[longestheld] = -1;
+			m_Available.emplace(m_Available.begin(), longestheld);
+		}
+
+		int voice = m_Available.back();
+		m_Available.pop_back();
+		m_Pressed.emplace(m_Pressed.begin(), voice);
+		m_Notes[voice] = note;
+		return voice;
+	}
+
+	template<typename Fun>
+	void Release(int note, Fun&& fun)
+	{
+		while (true)
+		{
+			auto it = std::find(m_Notes.begin(), m_Notes.end(), note);
+			if (it == m_Notes.end())
+				break;
+
+			int voice = static_cast<int>(std::distance(m_Notes.begin(), it));
+			fun(voice);
+			m_Notes[voice] = -1;
+			m_Available.emplace(m_Available.begin(), voice);
+			auto it2 = std::find(m_Pressed.begin(), m_Pressed.end(), voice);
+			if (it2 != m_Pressed.end())
+				m_Pressed.erase(it2);
+		}
+	}
+
+private:
+	std::vector<int> m_Notes, m_Available, m_Pressed;
+};
+
+/**
+ * Voice that does nothing, so the bank only measures its bookkeeping.
+ */
+class NullVoice : public Voice
+{
+public:
+	float Generate() override { return m_Gate; }
+	void Trigger() override {}
+	void Gate(bool g) override { m_Gate = g; }
+	void Frequency(double) override {}
+	bool Done() override { return !m_Gate; }
+
+private:
+	bool m_Gate = false;
+};
+
+/**
+ * Wavetable voice with an ADSR that renders whole blocks, the VoiceBank counterpart
+ * of a lane in VoiceLanes.
+ */
+class WavetableVoice : public Voice
+{
+public:
+	WavetableVoice()
+		: m_Oscillator(BandLimitedWavetable::Saw())
+	{
+		m_Envelope.sampleRate = 48000, m_Envelope.s = 0.5;
+	}
+
+	float Generate() override { return m_Oscillator.Process() * m_Envelope.Generate(); }
+	void Trigger() override { m_Envelope.Trigger(); }
+	void Gate(bool g) override { m_Envelope.Gate(g); }
+	void Frequency(double f) override { m_Oscillator.Frequency(f); }
+	bool Done() override { return m_Envelope.Done(); }
+
+	void Render(float* out, int frames) override
+	{
+		float osc[64], env[64];
+		for (int i = 0; i < frames; i += 64)
+		{
+			const int n = std::min(64, frames - i);
+			m_Oscillator.Render(osc, n);
+			m_Envelope.Render(env, n);
+			for (int j = 0; j < n; j++)
+				out[i + j] += osc[j] * env[j];
+		}
+	}
+
+private:
+	WavetableOscillator m_Oscillator;
+	ADSR m_Envelope;
+};
+
+/**
+ * Random presses and releases over all 128 notes, slightly more presses so the
+ * voices run out and get stolen.
+ */
+std::vector<int> Storm()
+{
+	std::vector<int> events(Events);
+	uint32_t seed = 1;
+	for (auto& e : events)
+	{
+		seed = seed * 1664525 + 1013904223;
+		int note = (seed >> 8) % 128;
+		e = (seed >> 24) % 10 < 6 ? note : -1 - note;
+	}
+	return events;
+}
+
+template<typename Allocator>
+double Run(int voices, const std::vector<int>& events)
+{
+	return Time([&] {
+		Allocator allocator(voices);
+		int sum = 0;
+		for (int e : events)
+			if (e >= 0)
+				sum += allocator.Press(e);
+			else
+				allocator.Release(-1 - e, [&](int v) { sum += v; });
+		Use(sum);
+	});
+}
+
+double RunBank(int voices, const std::vector<int>& events)
+{
+	return Time([&] {
+		VoiceBank<NullVoice> bank(voices);
+		for (int e : events)
+			if (e >= 0)
+				bank.NotePress(e);
+			else
+				bank.NoteRelease(-1 - e);
+		Use(bank.Generate());
+	});
+}
+
+/**
+ * Cost per voice per sample of rendering a bank with all voices held, after every
+ * other voice was released and has ended.
+ */
+template<typename Bank>
+double RunRender(Bank& bank, int voices)
+{
+	constexpr int Block = 256, Blocks = 200;
+	for (int v = 0; v < voices; v++)
+		bank.NotePress(v % 128);
+	for (int v = 1; v < voices && v < 128; v += 2)
+		bank.NoteRelease(v);
+
+	std::vector<float> out(Block);
+	for (int b = 0; b < 40; b++)
+		bank.Generate(out.data(), Block);
+
+	return Time([&] {
+		for (int b = 0; b < Blocks; b++)
+			bank.Generate(out.data(), Block);
+		Use(out[0]);
+	}) / (double(Block) * Blocks * voices) * 1e9;
+}
+
+int main()
+{
+	auto events = Storm();
+	std::printf("MIDI storm of %d random press/release events, million events/s\n", Events);
+	for (int voices : { 16, 64, 256, 1024 })
+	{
+		double linear = Run<LinearAllocator>(voices, events);
+		double constant = Run<VoiceAllocator>(voices, events);
+		double bank = RunBank(voices, events);
+		std::printf("%5d voices: old allocator %7.1f, VoiceAllocator %7.1f, VoiceBank %7.1f\n",
+			voices, Events / linear * 1e-6, Events / constant * 1e-6, Events / bank * 1e-6);
+	}
+
+	std::printf("\nRendering saw voices with an ADSR, half of them ended, ns per voice per sample\n");
+	for (int voices : { 16, 64, 256 })
+	{
+		VoiceBank<WavetableVoice> bank(voices);
+		LaneVoiceBank lanes(voices);
+		lanes.Lanes().envelope.s = 0.5, lanes.Lanes().envelope.RecalculateParameters();
+		double a = RunRender(bank, voices), b = RunRender(lanes, voices);
+		std::printf("%5d voices: VoiceBank %6.2f, LaneVoiceBank %6.2f (%.1fx)\n", voices, a, b, a / b);
+	}
+}
@@ -0,0 +1,176 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+/**
+ * Records the parts the block is split in, and the value of the automated Parameter in each.
+ */
+class Effect : public EffectBase
+{
+public:
+	Effect()
+		: EffectBase("Effect"),
+		gain(Parameter("Gain", ParameterType::Knob)),
+		bypass(Toggle("Bypass"))
+	{
+		gain.Range({ 0, 1 });
+	}
+
+	using EffectBase::ProcessBlock;
+
+	float Process(float in, int) override { return in; }
+
+	void ProcessBlock(const float* const*, float* const* out, int channels, int frames) override
+	{
+		parts.push_back(frames);
+		for (int c = 0; c < channels; c++)
+			for (int i = 0; i < frames; i++)
+				out[c][i] = gain.NormalizedValue();
+	}
+
+	SoundMixr::Parameter& gain;
+	SoundMixr::ToggleButton& bypass;
+	std::vector<int> parts;
+};
+
+/**
+ * Records the parts the block is rendered in, and the value of the Parameter at each midi event.
+ */
+class Generator : public GeneratorBase
+{
+public:
+	Generator()
+		: GeneratorBase("Generator"),
+		gain(Parameter("Gain", ParameterType::Knob))
+	{
+		gain.Range({ 0, 1 });
+	}
+
+	float Generate(int) override { return gain.NormalizedValue(); }
+	void ReceiveMidi(MidiData) override { midi.push_back(gain.NormalizedValue()); }
+
+	void Render(float* const* out, int channels, int offset, int frames) override
+	{
+		parts.push_back(frames);
+		GeneratorBase::Render(out, channels, offset, frames);
+	}
+
+	SoundMixr::Parameter& gain;
+	std::vector<int> parts;
+	std::vector<double> midi;
+};
+
+constexpr int Frames = 64;
+
+void TestEffectSplit()
+{
+	Effect effect;
+	float a[Frames], b[Frames];
+	float* io[]{ a, b };
+
+	// Events at the same offset are one split, events past the block apply at its end
+	const AutomationEvent events[]{
+		{ 10, effect.gain.ObjectId(), 0.25f },
+		{ 10, effect.bypass.ObjectId(), 1.0f },
+		{ 20, effect.gain.ObjectId(), 0.75f },
+		{ 200, effect.gain.ObjectId(), 1.0f },
+	};
+	effect.ProcessBlock(io, io, 2, Frames, events, 4);
+
+	CHECK((effect.parts == std::vector<int>{ 10, 10, 44 }));
+	for (float* x : io)
+	{
+		CHECK(x[0] == 0 && x[9] == 0);
+		CHECK(x[10] == 0.25f && x[19] == 0.25f);
+		CHECK(x[20] == 0.75f && x[Frames - 1] == 0.75f);
+	}
+	CHECK(effect.gain.NormalizedValue() == 1);
+	CHECK(!effect.bypass.State());
+
+	// The events per Parameter, without the ones for other Objects
+	const AutomationEvent* gain = nullptr;
+	CHECK(effect.Automation(effect.gain.ObjectId(), gain) == 3);
+	CHECK(gain[0].offset == 10 && gain[1].offset == 20 && gain[2].offset == 200);
+	const AutomationEvent* bypass = nullptr;
+	CHECK(effect.Automation(effect.bypass.ObjectId(), bypass) == 0);
+}
+
+void TestRamp()
+{
+	Effect effect;
+	const AutomationEvent events[]{ { 0, effect.gain.ObjectId(), 0.5f }, { 32, effect.gain.ObjectId(), 1.0f } };
+	effect.Automate(events, 2);
+
+	float ramp[Frames];
+	effect.Ramp(effect.gain, ramp, Frames);
+	CHECK(ramp[0] == 0.5f && ramp[31] == 0.5f);
+	CHECK(ramp[32] == 1 && ramp[Frames - 1] == 1);
+}
+
+/**
+ * Ramp with events gives the same values as calling Value() once per sample and
+ * applying each event at its offset, for every smoothing and scaling.
+ */
+void TestRampMatchesValue()
+{
+	using Scaling = ParameterData::Scaling;
+	using Smoothing = ParameterData::Smoothing;
+	const AutomationEvent events[]{ { 0, 0, 0.2f }, { 17, 0, 0.9f }, { 17, 0, 0.6f }, { 40, 0, 0.05f } };
+
+	for (bool smoothing : { false, true })
+		for (Smoothing smoothingType : { Smoothing::Exponential, Smoothing::Linear })
+			for (Scaling scalingType : { Scaling::Pow, Scaling::Log })
+				for (double scaling : { 1.0, 2.5 })
+				{
+					ParameterData data;
+					data.range = scalingType == Scaling::Log ? Pair<double>{ 20, 20000 } : Pair<double>{ -10, 30 };
+					data.scalingType = scalingType, data.scaling = scaling;
+					data.enableSmoothing = smoothing, data.smoothingType = smoothingType;
+					data.smoothingAmount = smoothingType == Smoothing::Linear ? 0.02 : 0.1;
+
+					SoundMixr::Parameter ramped, reference;
+					ramped.Data(data), reference.Data(data);
+
+					float ramp[Frames];
+					ramped.Ramp(ramp, Frames, events, 4);
+
+					int e = 0;
+					for (int i = 0; i < Frames; i++)
+					{
+						while (e < 4 && events[e].offset == i)
+							reference.Automate(events[e++].value);
+						const double value = reference.Value();
+						CHECK_NEAR(ramp[i], value, 1e-5 * std::max(1.0, std::abs(value)));
+					}
+				}
+}
+
+void TestGeneratorSplit()
+{
+	Generator generator;
+	float a[Frames];
+	float* out[]{ a };
+
+	// Automation at the offset of a midi event is applied before it
+	const MidiEvent midi[]{ { 5, MidiData(0b1001, 0) }, { 40, MidiData(0b1000, 0) } };
+	const AutomationEvent automation[]{
+		{ 5, generator.gain.ObjectId(), 0.5f },
+		{ 30, generator.gain.ObjectId(), 1.0f },
+	};
+	generator.GenerateBlock(out, 1, Frames, midi, 2, automation, 2);
+
+	CHECK((generator.parts == std::vector<int>{ 5, 25, 10, 24 }));
+	CHECK((generator.midi == std::vector<double>{ 0.5, 1.0 }));
+	CHECK(a[4] == 0 && a[5] == 0.5f && a[29] == 0.5f && a[30] == 1);
+}
+
+int main()
+{
+	TestEffectSplit();
+	TestRamp();
+	TestRampMatchesValue();
+	TestGeneratorSplit();
+	return TestResult();
+}
@@ -0,0 +1,176 @@
+#include "Test.hpp"
+#include "Filters.hpp"
+#include <complex>
+#include <random>
+#include <vector>
+
+constexpr int Block = 64;
+
+BiquadParameters Peak(double f0)
+{
+	BiquadParameters p;
+	p.type = FilterType::PeakingEQ, p.f0 = f0, p.dbgain = 6, p.BW = 1;
+	p.RecalculateParameters();
+	return p;
+}
+
+/**
+ * Each parameter makes the coefficients dirty, setting the same value again doesn't,
+ * and Update() only recalculates dirty coefficients.
+ */
+void TestDirty()
+{
+	BiquadParameters p;
+	CHECK(p.Dirty());
+	CHECK(p.Update() && !p.Dirty());
+	CHECK(!p.Update());
+
+	p = Peak(1000);
+	CHECK(!p.Dirty());
+	p.f0 = 1000, p.Q = p.Q, p.dbgain = 6;
+	CHECK(!p.Dirty());
+
+	// A recalculation would overwrite the marker
+	p.b0a0 = 123;
+	CHECK(!p.Update() && p.b0a0 == 123);
+
+	const auto change = [](auto set) {
+		BiquadParameters p = Peak(1000);
+		set(p);
+		CHECK(p.Dirty());
+		CHECK(p.Update() && !p.Dirty());
+	};
+	change([](BiquadParameters& p) { p.f0 = 2000; });
+	change([](BiquadParameters& p) { p.Q = 2; });
+	change([](BiquadParameters& p) { p.dbgain = -3; });
+	change([](BiquadParameters& p) { p.sampleRate = 44100; });
+	change([](BiquadParameters& p) { p.type = FilterType::LowShelf; });
+}
+
+/**
+ * Direct form I with fixed coefficients, the reference for the block Apply.
+ */
+struct Reference
+{
+	double Apply(double x0, const double (&c)[5])
+	{
+		double y0 = c[0] * x0 + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+		x2 = x1, x1 = x0, y2 = y1, y1 = y0;
+		return y0;
+	}
+
+	double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+};
+
+/**
+ * After a change the coefficients go linearly from the old to the new ones over one
+ * block, reaching the new ones at its last sample, and stay there after.
+ */
+void TestInterpolation()
+{
+	BiquadParameters from = Peak(200), to = Peak(5000);
+	const double a[5]{ from.b0a0, from.b1a0, from.b2a0, from.a1a0, from.a2a0 };
+	const double b[5]{ to.b0a0, to.b1a0, to.b2a0, to.a1a0, to.a2a0 };
+
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> noise{ -1, 1 };
+	std::vector<float> in(3 * Block), out(3 * Block);
+	for (auto& x : in)
+		x = noise(rng);
+
+	BiquadFilter<> filter;
+	filter.Apply(&in[0], &out[0], Block, from);
+	filter.Apply(&in[Block], &out[Block], Block, to);
+	filter.Apply(&in[2 * Block], &out[2 * Block], Block, to);
+
+	Reference reference;
+	double error = 0;
+	for (int i = 0; i < 3 * Block; i++)
+	{
+		const double t = std::clamp(i - Block + 1, 0, Block) / double(Block);
+		double c[5];
+		for (int k = 0; k < 5; k++)
+			c[k] = a[k] + (b[k] - a[k]) * t;
+		error = std::max(error, std::abs(out[i] - reference.Apply(in[i], c)));
+	}
+	CHECK(error < 1e-5);
+}
+
+/**
+ * Designed coefficients are fetched once, the newest design wins, and they're the
+ * same as calculating them directly.
+ */
+void TestDesigner()
+{
+	BiquadDesigner designer;
+	BiquadParameters p;
+	CHECK(!designer.Fetch(p));
+
+	designer.Design(Peak(300));
+	designer.Design(Peak(700));
+	CHECK(designer.Fetch(p));
+	CHECK(!designer.Fetch(p));
+
+	const BiquadParameters expected = Peak(700);
+	CHECK(p.f0 == 700 && !p.Dirty());
+	CHECK(p.b0a0 == expected.b0a0 && p.b1a0 == expected.b1a0 && p.b2a0 == expected.b2a0);
+	CHECK(p.a1a0 == expected.a1a0 && p.a2a0 == expected.a2a0);
+
+	// Parameters that weren't designed yet are designed by Design()
+	BiquadParameters undesigned;
+	undesigned.type = FilterType::LowPass, undesigned.f0 = 1000;
+	designer.Design(undesigned);
+	CHECK(designer.Fetch(p) && p.type == FilterType::LowPass && !p.Dirty());
+}
+
+/**
+ * The combined response equals the product of every band's H(e^jw), evaluated directly,
+ * and only changes when a band does.
+ */
+void TestFrequencyResponse()
+{
+	std::vector<BiquadParameters> bands(4);
+	bands[0].type = FilterType::HighPass, bands[0].f0 = 40, bands[0].Q = 0.7;
+	bands[1].type = FilterType::LowShelf, bands[1].f0 = 150, bands[1].dbgain = 4, bands[1].S = 1;
+	bands[2] = Peak(3000);
+	bands[3].type = FilterType::Off;
+	for (auto& b : bands)
+		b.RecalculateParameters();
+
+	FrequencyResponse response;
+	response.Points(200, 20, 20000);
+	response.CalculatePhase(true);
+	CHECK(response.Update(bands));
+	CHECK(!response.Update(bands));
+
+	const auto check = [&] {
+		for (size_t i = 0; i < response.Frequencies().size(); i++)
+		{
+			const double w = 6.28318530718 * response.Frequencies()[i] / 48000;
+			const std::complex<double> z = std::polar(1.0, -w), z2 = z * z;
+			std::complex<double> h = 1;
+			for (auto& b : bands)
+				if (b.type != FilterType::Off)
+					h *= (b.b0a0 + b.b1a0 * z + b.b2a0 * z2) / (1.0 + b.a1a0 * z + b.a2a0 * z2);
+
+			CHECK_NEAR(response.Magnitude()[i], 20 * std::log10(std::abs(h)), 1e-9);
+
+			// The phases of the bands are summed, so compare them on the unit circle
+			CHECK(std::abs(std::polar(1.0, response.Phase()[i]) - h / std::abs(h)) < 1e-9);
+		}
+	};
+	check();
+
+	bands[2] = Peak(500);
+	CHECK(response.Update(bands));
+	check();
+}
+
+int main()
+{
+	TestDirty();
+	TestInterpolation();
+	TestDesigner();
+	TestFrequencyResponse();
+	return TestResult();
+}
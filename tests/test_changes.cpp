@@ -0,0 +1,76 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+class Knobs : public EffectBase
+{
+public:
+	Knobs(int n)
+		: EffectBase("Knobs")
+	{
+		for (int i = 0; i < n; i++)
+			knobs.push_back(&Parameter("", ParameterType::Knob));
+	}
+
+	float Process(float in, int) override { return in; }
+
+	std::vector<SoundMixr::Parameter*> knobs;
+};
+
+/**
+ * An Object changed several times between blocks is reported once, and can be
+ * queued again after the audio thread drained it.
+ */
+void TestCoalescing()
+{
+	Knobs plugin(8);
+	plugin.DrainChanges();
+	CHECK(plugin.DrainChanges().empty());
+
+	for (int i = 0; i < 10; i++)
+		plugin.knobs[3]->NormalizedValue(i / 10.0);
+	plugin.knobs[1]->Range({ 0, 10 });
+	plugin.knobs[3]->Scaling(2);
+	CHECK((plugin.DrainChanges() == std::vector<int>{ 3, 1 }));
+	CHECK(plugin.DrainChanges().empty());
+
+	// Acknowledged, so the next change is queued again
+	plugin.knobs[3]->NormalizedValue(1);
+	CHECK((plugin.DrainChanges() == std::vector<int>{ 3 }));
+
+	// Host automation comes from the audio thread itself and isn't queued
+	plugin.knobs[2]->Automate(0.5);
+	CHECK(plugin.DrainChanges().empty());
+}
+
+/**
+ * More changed Objects than fit in the queue aren't lost, the drain after the
+ * overflow returns every Object once, and after that the queue works as before.
+ */
+void TestOverflow()
+{
+	const int count = static_cast<int>(ChangeQueue::Capacity()) + 100;
+	Knobs plugin(count);
+	plugin.DrainChanges();
+
+	for (auto knob : plugin.knobs)
+		knob->NormalizedValue(0.5);
+
+	const std::vector<int>& changed = plugin.DrainChanges();
+	CHECK(changed.size() == static_cast<size_t>(count));
+	for (int i = 0; i < static_cast<int>(changed.size()); i++)
+		CHECK(changed[i] == i);
+	CHECK(plugin.DrainChanges().empty());
+
+	plugin.knobs[count - 1]->NormalizedValue(1);
+	CHECK((plugin.DrainChanges() == std::vector<int>{ count - 1 }));
+}
+
+int main()
+{
+	TestCoalescing();
+	TestOverflow();
+	return TestResult();
+}
@@ -0,0 +1,292 @@
+#include "Test.hpp"
+#include "Compressor.hpp"
+#include "FFT.hpp"
+#include <vector>
+
+constexpr double SampleRate = 48000;
+
+void Neutral(Compressor& c)
+{
+	c.pregain = 1, c.postgain = 1, c.mix = 0;
+}
+
+void Compressing(Compressor& c)
+{
+	c.pregain = 1, c.postgain = 1, c.mix = 1;
+	c.compressThreshhold = -20, c.compressRatio = 1 / 8.0;
+	c.expanderThreshhold = -80;
+	c.Attack(1), c.Release(50);
+}
+
+float Rms(const std::vector<float>& x, size_t from)
+{
+	double sum = 0;
+	for (size_t i = from; i < x.size(); i++)
+		sum += x[i] * x[i];
+	return (float)std::sqrt(sum / (x.size() - from));
+}
+
+/**
+ * Without gain changes the bands sum back to an allpass, so the magnitude response is flat.
+ */
+void TestFlatSum(int bands)
+{
+	constexpr size_t N = 8192;
+	MultibandCompressor multiband;
+	multiband.Bands(bands);
+	for (auto& b : multiband.bands)
+		Neutral(b);
+	multiband.Channels(1);
+
+	std::vector<float> x(N, 0.0f);
+	float* io[] = { x.data() };
+	x[0] = 1;
+	multiband.Process(io, io, 1, (int)N);
+
+	std::vector<FFT::Complex> spectrum(N / 2 + 1);
+	RealFFT fft(N);
+	fft.Forward(x.data(), spectrum.data());
+	for (size_t k = 1; k < N / 2; k++)
+		CHECK_NEAR(std::abs(spectrum[k]), 1, 0.001);
+}
+
+/**
+ * A tone in the lowest band is compressed like a single Compressor with the same settings.
+ */
+void TestMatchesCompressor()
+{
+	constexpr int N = 48000;
+	std::vector<float> a(N), b(N);
+	for (int i = 0; i < N; i++)
+		a[i] = b[i] = 0.5f * (float)std::sin(6.28318530718 * 50 * i / SampleRate);
+
+	Compressor single;
+	Compressing(single);
+	single.Channels(1);
+
+	MultibandCompressor multiband;
+	multiband.Bands(2);
+	multiband.Crossover(0, 2000);
+	for (auto& band : multiband.bands)
+		Compressing(band);
+	multiband.Channels(1);
+
+	float* pa[] = { a.data() };
+	float* pb[] = { b.data() };
+	for (int i = 0; i < N; i += 256)
+	{
+		const int n = std::min(256, N - i);
+		single.Process(pa, pa, 1, n);
+		multiband.Process(pb, pb, 1, n);
+		pa[0] += n, pb[0] += n;
+	}
+
+	// 6 dB over the threshold at a ratio of 8 is about 11.8 dB of reduction
+	const float rms = Rms(a, N / 2);
+	CHECK(rms < 0.5f / std::sqrt(2.0f) / 3);
+	CHECK_NEAR(Rms(b, N / 2) / rms, 1, 0.02);
+	CHECK(multiband.GainReduction(0) < 0.3);
+	CHECK(multiband.GainReduction(1) < 0.3);
+}
+
+/**
+ * Silence mutes the output, and nothing turns into NaN on the way.
+ */
+void TestSilence()
+{
+	MultibandCompressor multiband;
+	multiband.Bands(5);
+	for (auto& b : multiband.bands)
+		Compressing(b);
+	multiband.Lookahead(2);
+	multiband.Channels(2);
+	CHECK(multiband.Latency() == 96);
+
+	std::vector<float> l(4096, 0.0f), r(4096, 0.0f);
+	for (int i = 0; i < 1000; i++)
+		l[i] = r[i] = 0.3f * (float)std::sin(i * 0.05);
+
+	float* io[] = { l.data(), r.data() };
+	multiband.Process(io, io, 2, 4096);
+	bool finite = true;
+	for (int i = 0; i < 4096; i++)
+		finite = finite && std::isfinite(l[i]) && std::isfinite(r[i]);
+	CHECK(finite);
+	CHECK(l[4095] == 0 && r[4095] == 0);
+}
+
+/**
+ * Block processing with a detector update every sample is the per-sample path.
+ */
+void TestControlRate()
+{
+	constexpr int N = 24000;
+	std::vector<float> a(N), b(N);
+	for (int i = 0; i < N; i++)
+		a[i] = b[i] = (i / 4000 % 2 ? 0.8f : 0.05f) * (float)std::sin(6.28318530718 * 220 * i / SampleRate);
+
+	Compressor single, block;
+	Compressing(single), Compressing(block);
+	block.controlRate = 1;
+	block.Channels(1);
+
+	for (auto& x : a)
+		x = single.Process(x, 0);
+
+	float* pb[] = { b.data() };
+	for (int i = 0; i < N; i += 256)
+	{
+		const int n = std::min(256, N - i);
+		block.Process(pb, pb, 1, n);
+		pb[0] += n;
+	}
+
+	for (int i = 0; i < N; i++)
+		CHECK_NEAR(b[i], a[i], 1e-5);
+}
+
+/**
+ * The gain starts at unity, the first samples aren't faded in, also after a Reset.
+ */
+void TestUnityGain()
+{
+	Compressor compressor;
+	Neutral(compressor);
+	compressor.Channels(1);
+
+	std::vector<float> x(64, 0.5f);
+	float* io[] = { x.data() };
+	compressor.Process(io, io, 1, 64);
+	CHECK(x[0] == 0.5f && x[63] == 0.5f);
+
+	std::fill(x.begin(), x.end(), 0.0f);
+	compressor.Process(io, io, 1, 64);
+	compressor.Reset();
+	std::fill(x.begin(), x.end(), 0.5f);
+	compressor.Process(io, io, 1, 64);
+	CHECK(x[0] == 0.5f);
+}
+
+/**
+ * Gain reduction of both channels after a loud left and a quiet right channel.
+ */
+std::pair<double, double> Linked(Compressor::Linking linking, int rightGroup = 0)
+{
+	constexpr int N = 9600;
+	std::vector<float> l(N), r(N);
+	for (int i = 0; i < N; i++)
+	{
+		const float x = (float)std::sin(6.28318530718 * 220 * i / SampleRate);
+		l[i] = 0.8f * x, r[i] = 0.05f * x;
+	}
+
+	Compressor compressor;
+	Compressing(compressor);
+	compressor.linking = linking;
+	compressor.Channels(2);
+	compressor.Group(1, rightGroup);
+
+	float* io[] = { l.data(), r.data() };
+	compressor.Process(io, io, 2, N);
+	return { compressor.GainReduction(0), compressor.GainReduction(1) };
+}
+
+void TestLinking()
+{
+	auto [maxLeft, maxRight] = Linked(Compressor::Max);
+	auto [left, right] = Linked(Compressor::Independent);
+	auto [averageLeft, averageRight] = Linked(Compressor::Average);
+
+	// Independent only compresses the loud channel, Max compresses both as much
+	CHECK(left < 0.5 && right > 0.99);
+	CHECK(maxLeft == maxRight);
+	CHECK_NEAR(maxLeft, left, 1e-6);
+
+	// The average is quieter than the loud channel, so both are compressed less
+	CHECK(averageLeft == averageRight);
+	CHECK(averageLeft > maxLeft && averageLeft < 0.99);
+
+	// Grouped is Independent with a group per channel, and Max with one group
+	auto [groupedLeft, groupedRight] = Linked(Compressor::Grouped, 1);
+	CHECK_NEAR(groupedLeft, left, 1e-6);
+	CHECK_NEAR(groupedRight, right, 1e-6);
+	auto [oneLeft, oneRight] = Linked(Compressor::Grouped, 0);
+	CHECK_NEAR(oneLeft, maxLeft, 1e-6);
+	CHECK(oneLeft == oneRight);
+
+	// Without channels there is nothing to link or divide by
+	Compressor compressor;
+	compressor.linking = Compressor::Average;
+	compressor.Channels(0);
+	compressor.Process(nullptr, nullptr, 0, 64);
+	MultibandCompressor multiband;
+	multiband.linking = Compressor::Average;
+	multiband.Channels(0);
+	multiband.Process(nullptr, nullptr, 0, 64);
+}
+
+/**
+ * SlidingMaximum equals the maximum over its window, for window sizes around the
+ * ring wrapping and on random, rising and falling input.
+ */
+void TestSlidingMaximum()
+{
+	std::vector<float> x(5000);
+	uint32_t seed = 1;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		x[i] = i < 2000 ? (seed >> 8) / 16777216.0f : i < 3500 ? i * 0.001f : (5000 - i) * 0.001f;
+	}
+
+	for (int size : { 1, 2, 3, 16, 97, 1000 })
+	{
+		SlidingMaximum window;
+		window.Size(size);
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			float expected = 0;
+			for (size_t j = i + 1 - std::min<size_t>(i + 1, size); j <= i; j++)
+				expected = std::max(expected, x[j]);
+			CHECK(window.Process(x[i]) == expected);
+		}
+	}
+}
+
+/**
+ * Latency() is the lookahead in samples, and the audio is delayed by exactly that.
+ */
+void TestLatency()
+{
+	Compressor compressor;
+	Neutral(compressor);
+	compressor.Lookahead(2.5);
+	compressor.Channels(1);
+	CHECK(compressor.Latency() == 120);
+
+	std::vector<float> x(512, 0.0f);
+	x[10] = 1;
+	float* io[] = { x.data() };
+	compressor.Process(io, io, 1, (int)x.size());
+	CHECK(x[10 + compressor.Latency()] == 1);
+	CHECK(std::count(x.begin(), x.end(), 0.0f) == (long)x.size() - 1);
+
+	MultibandCompressor multiband;
+	multiband.Lookahead(2.5);
+	CHECK(multiband.Latency() == 120);
+}
+
+int main()
+{
+	for (int bands = 2; bands <= MultibandCompressor::MaxBands; bands++)
+		TestFlatSum(bands);
+
+	TestMatchesCompressor();
+	TestSilence();
+	TestControlRate();
+	TestUnityGain();
+	TestLinking();
+	TestSlidingMaximum();
+	TestLatency();
+	return TestResult();
+}
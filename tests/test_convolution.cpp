@@ -0,0 +1,147 @@
+#include "Test.hpp"
+#include "Filters.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+constexpr size_t Taps = 700;
+constexpr int Frames = 4000;
+
+using Params = KaiserBesselParameters<Taps, float>;
+
+/**
+ * Runs a filter over the input, alternating between per-sample and block calls.
+ */
+template<typename F, typename P>
+std::vector<float> Run(F& filter, P& p, const std::vector<float>& in)
+{
+	std::vector<float> out(in.size());
+	size_t i = 0;
+	for (int n = 1; i < in.size(); n = n * 3 % 97 + 1)
+	{
+		size_t len = std::min<size_t>(n, in.size() - i);
+		if (len == 1)
+			out[i] = filter.Apply(in[i], p);
+		else
+			filter.Apply(in.data() + i, out.data() + i, (int)len, p);
+		i += len;
+	}
+	return out;
+}
+
+/**
+ * Every tap of a Kaiser-Bessel kernel is set and it's symmetric, for odd and even M.
+ */
+template<size_t M>
+void TestKernel()
+{
+	KaiserBesselParameters<M, float> p;
+	std::fill(std::begin(p.H), std::end(p.H), 1e10f);
+	p.Fa = 0, p.Fb = 6000;
+	p.RecalculateParameters();
+
+	double sum = 0;
+	for (size_t i = 0; i < M; i++)
+	{
+		CHECK(p.H[i] == p.H[M - 1 - i]);
+		sum += p.H[i];
+	}
+
+	// Lowpass, so the DC gain is 1
+	CHECK_NEAR(sum, 1, 1e-2);
+	CHECK(std::abs(p.H[M - 1]) < 1e-2);
+}
+
+/**
+ * The direct form equals a plain convolution, also after its mirrored history wraps around.
+ */
+template<size_t M>
+void TestDirect(const std::vector<float>& in)
+{
+	using P = KaiserBesselParameters<M, float>;
+	P p;
+	p.Fa = 100, p.Fb = 5000;
+	p.RecalculateParameters();
+
+	DirectFIRFilter<M, P> direct;
+	auto out = Run(direct, p, in);
+	for (int i = 0; i < Frames; i++)
+	{
+		double y = 0;
+		for (size_t j = 0; j < M && j <= (size_t)i; j++)
+			y += p.H[j] * in[i - j];
+		CHECK_NEAR(out[i], y, 1e-5);
+	}
+}
+
+/**
+ * Output of the convolution equals the direct form output delayed by Latency().
+ */
+void TestMatchesDirect(Params& p, const std::vector<float>& in)
+{
+	DirectFIRFilter<Taps, Params> direct;
+	ConvolutionFIRFilter<Taps, Params> convolution;
+	CHECK(direct.Latency() == 0);
+
+	auto a = Run(direct, p, in);
+	auto b = Run(convolution, p, in);
+	const int latency = convolution.Latency();
+	for (int i = 0; i < latency; i++)
+		CHECK_NEAR(b[i], 0, 1e-6);
+	for (int i = latency; i < Frames; i++)
+		CHECK_NEAR(b[i], a[i - latency], 1e-4);
+}
+
+/**
+ * Loading the same kernel from a raw impulse response file gives the same output.
+ */
+void TestImpulseResponse(Params& p, const std::vector<float>& in)
+{
+	const char* path = "test_convolution.raw";
+	FILE* file = std::fopen(path, "wb");
+	CHECK(file != nullptr);
+	if (!file)
+		return;
+	std::fwrite(p.H, sizeof(float), Taps, file);
+	std::fclose(file);
+
+	ImpulseResponse ir{ path, ImpulseResponse::Format::Raw };
+	CHECK(ir.Valid() && ir.Length() == Taps);
+
+	// Parameters with a different kernel, which should be ignored after Load()
+	Params other;
+	std::fill(std::begin(other.H), std::end(other.H), 0.0f);
+
+	ConvolutionFIRFilter<Taps, Params> reference, loaded;
+	loaded.Load(ir);
+	auto a = Run(reference, p, in);
+	auto b = Run(loaded, other, in);
+	for (int i = 0; i < Frames; i++)
+		CHECK_NEAR(b[i], a[i], 1e-5);
+
+	ir.Close();
+	std::remove(path);
+}
+
+int main()
+{
+	std::srand(1);
+	Params p;
+	p.Fa = 100, p.Fb = 5000;
+	p.RecalculateParameters();
+
+	std::vector<float> in(Frames);
+	for (auto& v : in)
+		v = std::rand() / (float)RAND_MAX * 2 - 1;
+
+	TestKernel<64>();
+	TestKernel<65>();
+	TestDirect<64>(in);
+	TestDirect<67>(in);
+	TestMatchesDirect(p, in);
+	TestImpulseResponse(p, in);
+	static_assert(std::is_same_v<FIRFilter<Taps, Params>, DirectFIRFilter<Taps, Params>>);
+	static_assert(std::is_same_v<FastFIRFilter<Taps, Params>, ConvolutionFIRFilter<Taps, Params>>);
+
+	return TestResult();
+}
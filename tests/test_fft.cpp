@@ -0,0 +1,59 @@
+#include "Test.hpp"
+#include "FFT.hpp"
+#include <cstdlib>
+
+/**
+ * Compares the complex and real FFTs against a naive DFT for a few sizes.
+ */
+void TestSize(size_t n)
+{
+	std::vector<float> x(n);
+	for (auto& v : x)
+		v = std::rand() / (float)RAND_MAX * 2 - 1;
+
+	// Naive DFT in double precision
+	std::vector<std::complex<double>> dft(n);
+	for (size_t k = 0; k < n; k++)
+		for (size_t i = 0; i < n; i++)
+			dft[k] += (double)x[i] * std::polar(1.0, -6.28318530717958647 * double(i * k % n) / n);
+
+	const double eps = 1e-4 * n;
+
+	// Complex transform of the real signal
+	std::vector<FFT::Complex> z(x.begin(), x.end());
+	FFT fft(n);
+	fft.Forward(z.data());
+	for (size_t k = 0; k < n; k++)
+	{
+		CHECK_NEAR(z[k].real(), dft[k].real(), eps);
+		CHECK_NEAR(z[k].imag(), dft[k].imag(), eps);
+	}
+
+	fft.Inverse(z.data());
+	for (size_t i = 0; i < n; i++)
+		CHECK_NEAR(z[i].real(), x[i], 1e-5);
+
+	// Real transform, only the first half + 1 bins
+	std::vector<FFT::Complex> bins(n / 2 + 1);
+	RealFFT real(n);
+	real.Forward(x.data(), bins.data());
+	for (size_t k = 0; k <= n / 2; k++)
+	{
+		CHECK_NEAR(bins[k].real(), dft[k].real(), eps);
+		CHECK_NEAR(bins[k].imag(), dft[k].imag(), eps);
+	}
+
+	std::vector<float> y(n);
+	real.Inverse(bins.data(), y.data());
+	for (size_t i = 0; i < n; i++)
+		CHECK_NEAR(y[i], x[i], 1e-5);
+}
+
+int main()
+{
+	std::srand(1);
+	for (size_t n : { 2, 4, 8, 32, 128, 512, 2048 })
+		TestSize(n);
+
+	return TestResult();
+}
@@ -0,0 +1,64 @@
+#include "Test.hpp"
+#include "Base.hpp"
+
+using namespace SoundMixr;
+
+/**
+ * Levels set per channel reach the UI together, once the block is published, and
+ * reading them doesn't take a new snapshot.
+ */
+void TestVolumeSlider()
+{
+	VolumeSlider slider;
+	slider.Channels(2);
+
+	slider.SetValue(0, 0.5f), slider.SetReduce(0, 0.25f);
+	CHECK(!slider.Update());
+	slider.SetValue(1, 0.75f);
+	slider.Publish();
+
+	CHECK(slider.Values()[0] == 0 && slider.Values()[1] == 0);
+	CHECK(slider.Update());
+	CHECK(slider.Values()[0] == 0.5f && slider.Values()[1] == 0.75f);
+	CHECK(slider.Reduces()[0] == 0.25f && slider.Reduces()[1] == 0);
+	CHECK(!slider.Update());
+
+	// Channels that aren't set again keep their level
+	slider.SetValue(1, 0.1f);
+	CHECK(slider.Values()[1] == 0.75f);
+	slider.Publish();
+	CHECK(slider.Update());
+	CHECK(slider.Values()[0] == 0.5f && slider.Values()[1] == 0.1f);
+}
+
+/**
+ * The peak and rms of measured blocks, and the ballistics on the UI side.
+ */
+void TestLevelMeter()
+{
+	LevelMeter meter;
+	meter.Channels(1);
+	meter.decay = 20, meter.hold = 0.5;
+
+	const float block[4]{ 0.5f, -1.0f, 0.5f, 0 };
+	meter.Process(0, block, 4);
+	meter.Publish();
+	CHECK(meter.Update(0.1));
+	CHECK(meter.Latest().peak[0] == 1);
+	CHECK_NEAR(meter.Latest().rms[0], std::sqrt(1.5 / 4), 1e-6);
+	CHECK(meter.Peak()[0] == 1 && meter.Hold()[0] == 1);
+
+	// Without new blocks the level falls 20 dB per second, the hold waits first
+	CHECK(!meter.Update(0.25));
+	CHECK_NEAR(meter.Peak()[0], std::pow(10.0, -0.25), 1e-6);
+	CHECK(meter.Hold()[0] == 1);
+	CHECK(!meter.Update(0.5));
+	CHECK(meter.Hold()[0] < 1);
+}
+
+int main()
+{
+	TestVolumeSlider();
+	TestLevelMeter();
+	return TestResult();
+}
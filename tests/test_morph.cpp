@@ -0,0 +1,127 @@
+#include "Test.hpp"
+#include "Base.hpp"
+
+using namespace SoundMixr;
+
+class Morphable : public EffectBase
+{
+public:
+	Morphable()
+		: EffectBase("Morphable"),
+		gain(Parameter("Gain", ParameterType::Knob)),
+		mix(Parameter("Mix", ParameterType::Knob)),
+		mode(DropDown("Mode")),
+		bypass(Toggle("Bypass")),
+		x(Parameter("X", ParameterType::Knob)),
+		y(Parameter("Y", ParameterType::Knob)),
+		xy(XYController(x, y))
+	{
+		gain.Range({ 0, 1 }), mix.Range({ 0, 1 }), x.Range({ 0, 1 }), y.Range({ 0, 1 });
+		mode.AddOption("A", 0), mode.AddOption("B", 1), mode.AddOption("C", 2), mode.AddOption("D", 3);
+	}
+
+	float Process(float in, int) override { return in; }
+
+	/**
+	 * Set the state that's captured into a snapshot.
+	 */
+	void Set(double g, double m, int selected, bool state)
+	{
+		gain.NormalizedValue(g), mix.NormalizedValue(m), mode.Select(selected), bypass.State(state);
+	}
+
+	SoundMixr::Parameter& gain, & mix;
+	SoundMixr::DropDown& mode;
+	SoundMixr::ToggleButton& bypass;
+	SoundMixr::Parameter& x, & y;
+	SoundMixr::XYController& xy;
+};
+
+/**
+ * Parameters are interpolated between 2 snapshots, discrete objects switch halfway.
+ */
+void TestTwoSnapshots()
+{
+	Morphable plugin;
+	PresetMorph morph{ plugin, 2 };
+	plugin.Set(0.2, 1.0, 0, false), morph.Capture(0);
+	plugin.Set(0.6, 0.0, 2, true), morph.Capture(1);
+
+	CHECK(morph.Morph(0, 1, 0.25));
+	CHECK_NEAR(plugin.gain.NormalizedValue(), 0.3, 1e-12);
+	CHECK_NEAR(plugin.mix.NormalizedValue(), 0.75, 1e-12);
+	CHECK(plugin.mode.Selected() == 0 && !plugin.bypass.State());
+	CHECK(!morph.Morph(0, 1, 0.25));
+
+	// A tie keeps the first snapshot, past halfway it's the second
+	morph.Morph(0, 1, 0.5);
+	CHECK(plugin.mode.Selected() == 0 && !plugin.bypass.State());
+	morph.Morph(0, 1, 0.501);
+	CHECK(plugin.mode.Selected() == 2 && plugin.bypass.State());
+	morph.Morph(0, 1, 0.499);
+	CHECK(plugin.mode.Selected() == 0 && !plugin.bypass.State());
+
+	morph.Morph(0, 1, 1);
+	CHECK_NEAR(plugin.gain.NormalizedValue(), 0.6, 1e-12);
+	CHECK(plugin.mix.NormalizedValue() == 0);
+}
+
+/**
+ * Bilinear weights for 4 snapshots in the corners, driven by an XYController whose
+ * parameters are excluded so the morph doesn't move its own position.
+ */
+void TestCorners()
+{
+	Morphable plugin;
+	PresetMorph morph{ plugin };
+	morph.Exclude(plugin.x), morph.Exclude(plugin.y);
+
+	plugin.Set(0.0, 0, 0, false), morph.Capture(0);
+	plugin.Set(0.4, 0, 1, false), morph.Capture(1);
+	plugin.Set(0.8, 0, 2, true), morph.Capture(2);
+	plugin.Set(1.0, 0, 3, true), morph.Capture(3);
+
+	// Weights (1 - x)(1 - y), x(1 - y), (1 - x)y and xy for x = 0.25, y = 0.75
+	plugin.x.NormalizedValue(0.25), plugin.y.NormalizedValue(0.75);
+	CHECK(morph.Morph(plugin.xy, 0, 1, 2, 3));
+	const double expected = 0.1875 * 0 + 0.0625 * 0.4 + 0.5625 * 0.8 + 0.1875 * 1.0;
+	CHECK_NEAR(plugin.gain.NormalizedValue(), expected, 1e-12);
+	CHECK(plugin.mode.Selected() == 2 && plugin.bypass.State());
+	CHECK(plugin.x.NormalizedValue() == 0.25 && plugin.y.NormalizedValue() == 0.75);
+
+	// Each corner is its own snapshot
+	const double corners[4][2]{ { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+	const double gains[4]{ 0.0, 0.4, 0.8, 1.0 };
+	for (int k = 0; k < 4; k++)
+	{
+		morph.Morph(0, 1, 2, 3, corners[k][0], corners[k][1]);
+		CHECK_NEAR(plugin.gain.NormalizedValue(), gains[k], 1e-12);
+		CHECK(plugin.mode.Selected() == k);
+	}
+}
+
+/**
+ * Excluded objects keep their value, the others still morph.
+ */
+void TestExclude()
+{
+	Morphable plugin;
+	PresetMorph morph{ plugin, 2 };
+	plugin.Set(0.0, 0.0, 0, false), morph.Capture(0);
+	plugin.Set(1.0, 1.0, 1, true), morph.Capture(1);
+
+	morph.Exclude(plugin.mix), morph.Exclude(plugin.mode);
+	plugin.Set(0.5, 0.3, 3, false);
+	morph.Morph(0, 1, 0.9);
+	CHECK_NEAR(plugin.gain.NormalizedValue(), 0.9, 1e-12);
+	CHECK(plugin.mix.NormalizedValue() == 0.3 && plugin.mode.Selected() == 3);
+	CHECK(plugin.bypass.State());
+}
+
+int main()
+{
+	TestTwoSnapshots();
+	TestCorners();
+	TestExclude();
+	return TestResult();
+}
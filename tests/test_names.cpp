@@ -0,0 +1,39 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <string>
+
+using namespace SoundMixr;
+
+class Names : public EffectBase
+{
+public:
+	Names()
+		: EffectBase("Names")
+	{
+		for (int i = 0; i < 100; i++)
+			Parameter("Knob " + std::to_string(i), ParameterType::Knob);
+		Toggle("Bypass");
+		DropDown(), DropDown();
+	}
+
+	float Process(float in, int) override { return in; }
+};
+
+int main()
+{
+	Names plugin;
+	for (int i = 0; i < 100; i++)
+		CHECK(plugin.Find("Knob " + std::to_string(i)) == i);
+	CHECK(plugin.Find("Bypass") == 100);
+
+	// Names that were never added, and unnamed Objects, aren't found
+	CHECK(plugin.Find("Knob 100") == -1);
+	CHECK(plugin.Find("") == -1);
+
+	// Typed lookups check the type
+	auto bypass = plugin.Find<ToggleButton>("Bypass");
+	CHECK(plugin.Get(bypass) != nullptr && plugin.Get(bypass)->Name() == "Bypass");
+	CHECK(plugin.Get(plugin.Find<SoundMixr::Parameter>("Bypass")) == nullptr);
+	CHECK(plugin.Get(Handle<ToggleButton>{ 1000 }) == nullptr);
+	return TestResult();
+}
@@ -0,0 +1,85 @@
+#include "Test.hpp"
+#include "Oversampling.hpp"
+#include <vector>
+
+constexpr double SampleRate = 48000;
+constexpr double Pi = 3.14159265358979;
+constexpr int Frames = 4800;
+constexpr int Settle = 1200; // Samples skipped before measuring
+
+/**
+ * Amplitude of a sine in the output after the filters settled, from its RMS, so
+ * it doesn't depend on where the samples fall with a fractional latency.
+ */
+double Amplitude(const std::vector<float>& out)
+{
+	double sum = 0;
+	for (int i = Settle; i < Frames; i++)
+		sum += out[i] * out[i];
+	return std::sqrt(2 * sum / (Frames - Settle));
+}
+
+/**
+ * A tone well below Nyquist passes through unchanged in level.
+ */
+void TestPassband(int factor)
+{
+	Oversampler<> oversampler{ factor };
+	std::vector<float> in(Frames), out(Frames);
+	for (int i = 0; i < Frames; i++)
+		in[i] = std::sin(2 * Pi * 1000 * i / SampleRate);
+
+	oversampler.Process(in.data(), out.data(), Frames, [](float*, int) {});
+	CHECK_NEAR(Amplitude(out), 1, 1e-3);
+}
+
+/**
+ * A tone above the base Nyquist, generated at the oversampled rate, doesn't
+ * alias back into the output.
+ */
+void TestStopband(int factor)
+{
+	Oversampler<> oversampler{ factor };
+	std::vector<float> in(Frames), out(Frames);
+	const double rate = SampleRate * factor;
+	long phase = 0;
+	oversampler.Process(in.data(), out.data(), Frames, [&](float* data, int n) {
+		for (int i = 0; i < n; i++, phase++)
+			data[i] = std::sin(2 * Pi * 36000 * phase / rate);
+	});
+
+	// 80 dB attenuation by default
+	CHECK(Amplitude(out) < 1e-3);
+}
+
+/**
+ * Latency() is where the impulse response is centred.
+ */
+void TestLatency(int factor)
+{
+	Oversampler<> oversampler{ factor };
+	std::vector<float> in(Frames), out(Frames);
+	in[0] = 1;
+	oversampler.Process(in.data(), out.data(), Frames, [](float*, int) {});
+
+	// The response is symmetric, so its centroid is its delay
+	double sum = 0, weighted = 0;
+	for (int i = 0; i < Frames; i++)
+		sum += out[i], weighted += out[i] * i;
+	CHECK_NEAR(sum, 1, 1e-3);
+	CHECK_NEAR(weighted / sum, oversampler.Latency(), 0.05);
+}
+
+int main()
+{
+	for (int factor : { 2, 4, 8 })
+	{
+		TestPassband(factor);
+		TestStopband(factor);
+		TestLatency(factor);
+	}
+
+	Oversampler<> none{ 1 };
+	CHECK(none.Factor() == 1 && none.Latency() == 0);
+	return TestResult();
+}
@@ -0,0 +1,39 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+/**
+ * Records the order Process is called in, and outputs a running count.
+ */
+class Recorder : public EffectBase
+{
+public:
+	Recorder() : EffectBase("Recorder") {}
+
+	float Process(float in, int c) override
+	{
+		calls.push_back(c);
+		return in + calls.size();
+	}
+
+	std::vector<int> calls;
+};
+
+int main()
+{
+	// The default ProcessBlock calls Process interleaved, like a host calling Process directly
+	Recorder effect;
+	float a[4]{ 1, 2, 3, 4 }, b[4]{ 5, 6, 7, 8 };
+	float* io[2]{ a, b };
+	effect.ProcessBlock(io, io, 2, 4);
+
+	CHECK(effect.calls.size() == 8);
+	for (size_t i = 0; i < effect.calls.size(); i++)
+		CHECK(effect.calls[i] == int(i % 2));
+
+	CHECK(a[0] == 1 + 1 && b[0] == 5 + 2);
+	CHECK(a[3] == 4 + 7 && b[3] == 8 + 8);
+	return TestResult();
+}
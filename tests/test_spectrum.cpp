@@ -0,0 +1,63 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr double SampleRate = 48000;
+constexpr double Pi = 3.14159265358979;
+
+/**
+ * Sizes are rounded up to a power of 2 within the supported range.
+ */
+void TestSize()
+{
+	SpectrumAnalyzer analyzer{ 3000 };
+	CHECK(analyzer.Size() == 4096);
+	analyzer.Configure(10, 64, SampleRate);
+	CHECK(analyzer.Size() == 64);
+	analyzer.Configure(2048, 64, SampleRate);
+	CHECK(analyzer.Size() == 2048);
+	analyzer.Configure(1 << 20, 64, SampleRate);
+	CHECK(analyzer.Size() == SpectrumAnalyzer::MaxSize);
+}
+
+/**
+ * A full scale sine shows up at 0 dB in the bin containing its frequency.
+ */
+void TestPeak(double frequency)
+{
+	SpectrumAnalyzer analyzer{ 4096, 128, SampleRate };
+	analyzer.FrameRate(240), analyzer.Smoothing(0);
+
+	// More than one frame, the worker only analyzes the newest samples
+	std::vector<float> sine(3 * analyzer.Size());
+	for (size_t i = 0; i < sine.size(); i++)
+		sine[i] = std::sin(2 * Pi * frequency * i / SampleRate);
+	analyzer.Push(sine.data(), static_cast<int>(sine.size()));
+
+	bool fresh = false;
+	for (int tries = 0; tries < 1000 && !fresh; tries++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		fresh = analyzer.Update();
+	}
+	CHECK(fresh);
+
+	const std::vector<float>& magnitudes = analyzer.Magnitudes();
+	const std::vector<float>& frequencies = analyzer.Frequencies();
+	const size_t peak = std::max_element(magnitudes.begin(), magnitudes.end()) - magnitudes.begin();
+
+	// Bins are log-spaced, the frequency is within half a bin of the peak's centre
+	const double halfBin = std::log(SampleRate / 2 / 20) / magnitudes.size() / 2;
+	CHECK(std::abs(std::log(frequency / frequencies[peak])) <= halfBin);
+	CHECK_NEAR(magnitudes[peak], 0, 1.5);
+}
+
+int main()
+{
+	TestSize();
+	TestPeak(1000);
+	TestPeak(7000);
+	return TestResult();
+}
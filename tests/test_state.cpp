@@ -0,0 +1,150 @@
+#include "Test.hpp"
+#include "Base.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+/**
+ * One Object of every type that has state.
+ */
+class State : public EffectBase
+{
+public:
+	State()
+		: EffectBase("State"),
+		gain(Parameter("Gain", ParameterType::Knob)),
+		mode(DropDown("Mode")),
+		bypass(Toggle("Bypass")),
+		radio(RadioButton("Radio", 1)),
+		dynamics(DynamicsSlider())
+	{
+		gain.Range({ 0, 10 });
+		mode.AddOption("A", 0), mode.AddOption("B", 1), mode.AddOption("C", 2);
+	}
+
+	using EffectBase::operator=;
+
+	float Process(float in, int) override { return in; }
+
+	SoundMixr::Parameter& gain;
+	SoundMixr::DropDown& mode;
+	SoundMixr::ToggleButton& bypass;
+	SoundMixr::RadioButton& radio;
+	SoundMixr::DynamicsSlider& dynamics;
+};
+
+void Change(State& s)
+{
+	s.gain.Value(7.5);
+	s.gain.MidiLink({ 1, 2, 3 });
+	s.mode.Select(2);
+	s.bypass.State(true);
+	s.radio.Selected(true);
+	s.dynamics.CompressorThreshhold(-24);
+	s.dynamics.Lookahead(5);
+}
+
+void CheckChanged(State& s)
+{
+	CHECK_NEAR(s.gain.NormalizedValue(), 0.75, 1e-9);
+	CHECK(s.gain.MidiLink().channel == 1 && s.gain.MidiLink().control == 2 && s.gain.MidiLink().device == 3);
+	CHECK(s.mode.Selected() == 2);
+	CHECK(s.bypass.State());
+	CHECK(s.radio.Selected());
+	CHECK(s.dynamics.CompressorThreshhold() == -24);
+	CHECK(s.dynamics.Lookahead() == 5);
+}
+
+std::vector<uint8_t> Save(State& s)
+{
+	std::vector<uint8_t> data(s.StateSize());
+	CHECK(s.Save(data.data(), data.size()) == data.size());
+	return data;
+}
+
+void TestRoundTrip()
+{
+	State a, b;
+	Change(a);
+	auto data = Save(a);
+	CHECK(b.Load(data.data(), data.size()));
+	CheckChanged(b);
+
+	// Binary and json give the same state
+	State c;
+	c = static_cast<nlohmann::json>(a);
+	CHECK(Save(c) == data);
+}
+
+void TestSmallBuffer()
+{
+	State a;
+	uint8_t data[8]{};
+	CHECK(a.Save(data, sizeof(data)) == a.StateSize());
+	CHECK(a.Save(nullptr, 0) == a.StateSize());
+}
+
+void TestBadState()
+{
+	State a, b;
+	Change(a);
+	auto data = Save(a);
+
+	// Wrong magic or a newer version isn't loaded at all
+	auto bad = data;
+	bad[0] ^= 0xFF;
+	CHECK(!b.Load(bad.data(), bad.size()));
+	bad = data;
+	bad[4] = 0xFF;
+	CHECK(!b.Load(bad.data(), bad.size()));
+	CHECK(!b.Load(data.data(), 3));
+	CHECK(b.mode.Selected() != 2);
+
+	// Truncated state loads what is there and reports the failure
+	CHECK(!b.Load(data.data(), data.size() - 1));
+	CHECK_NEAR(b.gain.NormalizedValue(), 0.75, 1e-9);
+}
+
+std::vector<uint8_t> SaveDelta(State& s, uint64_t since)
+{
+	std::vector<uint8_t> data(s.SaveDelta(since, nullptr, 0));
+	CHECK(s.SaveDelta(since, data.data(), data.size()) == data.size());
+	return data;
+}
+
+void TestDelta()
+{
+	State a, b;
+	const uint64_t start = a.Generation();
+	const size_t empty = SaveDelta(a, start).size();
+
+	// Only the changed Object is in the delta
+	a.mode.Select(1);
+	auto delta = SaveDelta(a, start);
+	CHECK(delta.size() > empty && delta.size() < a.StateSize());
+	CHECK(b.LoadDelta(delta.data(), delta.size()));
+	CHECK(b.mode.Selected() == 1);
+	CHECK(!b.bypass.State());
+
+	// Changes after reading the generation end up in the next delta
+	const uint64_t since = a.Generation();
+	Change(a);
+	delta = SaveDelta(a, since);
+	CHECK(b.LoadDelta(delta.data(), delta.size()));
+	CheckChanged(b);
+	CHECK(SaveDelta(a, a.Generation()).size() == empty);
+
+	// A delta isn't a full state and the other way around
+	auto full = Save(a);
+	CHECK(!b.LoadDelta(full.data(), full.size()));
+	CHECK(!b.Load(delta.data(), delta.size()));
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestSmallBuffer();
+	TestBadState();
+	TestDelta();
+	return TestResult();
+}
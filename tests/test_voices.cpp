@@ -0,0 +1,128 @@
+#include "Test.hpp"
+#include "Oscillator.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+/**
+ * Wavetable oscillator with an ADSR, counts the per-sample calls.
+ */
+class SynthVoice : public Voice
+{
+public:
+	SynthVoice()
+		: oscillator(BandLimitedWavetable::Saw())
+	{
+		envelope.sampleRate = 48000, envelope.s = 0.5;
+	}
+
+	float Generate() override { calls++; return oscillator.Process() * envelope.Generate(); }
+	void Trigger() override { envelope.Trigger(); }
+	void Gate(bool g) override { envelope.Gate(g); }
+	void Frequency(double f) override { oscillator.Frequency(f); }
+	bool Done() override { return envelope.Done(); }
+
+	WavetableOscillator oscillator;
+	ADSR envelope;
+	int calls = 0;
+};
+
+/**
+ * The same voice rendering whole blocks.
+ */
+class BlockVoice : public SynthVoice
+{
+public:
+	void Render(float* out, int frames) override
+	{
+		float osc[64], env[64];
+		for (int i = 0; i < frames; i += 64)
+		{
+			const int n = std::min(64, frames - i);
+			oscillator.Render(osc, n);
+			envelope.Render(env, n);
+			for (int j = 0; j < n; j++)
+				out[i + j] += osc[j] * env[j];
+		}
+	}
+};
+
+constexpr int Block = 256;
+constexpr int Frames = 188 * Block;
+
+/**
+ * Play a few notes, pressed and released at block boundaries.
+ */
+template<typename Bank, typename Render>
+std::vector<float> Play(Bank& bank, Render render)
+{
+	std::vector<float> out(Frames);
+	for (int i = 0; i < Frames; i += Block)
+	{
+		if (i == 0)
+			bank.NotePress(60), bank.NotePress(64);
+		if (i == 40 * Block)
+			bank.NotePress(96);
+		if (i == 80 * Block)
+			bank.NoteRelease(60), bank.NoteRelease(64), bank.NoteRelease(96);
+		render(bank, &out[i], Block);
+	}
+	return out;
+}
+
+void TestBlockGenerate()
+{
+	VoiceBank<SynthVoice> a(8), b(8);
+	VoiceBank<BlockVoice> c(8);
+	auto perSample = Play(a, [](auto& bank, float* out, int n) {
+		for (int i = 0; i < n; i++)
+			out[i] = bank.Generate();
+	});
+	auto block = Play(b, [](auto& bank, float* out, int n) { bank.Generate(out, n); });
+	auto rendered = Play(c, [](auto& bank, float* out, int n) { bank.Generate(out, n); });
+
+	// The envelope ends during the release, after that the output is silent
+	CHECK(perSample[Frames / 4] != 0);
+	CHECK(perSample[Frames - 1] == 0);
+
+	// ADSR::Generate keeps the envelope in double, ADSR::Render in float
+	for (int i = 0; i < Frames; i++)
+	{
+		CHECK(block[i] == perSample[i]);
+		CHECK_NEAR(rendered[i], perSample[i], 1e-4);
+	}
+
+	// Voices that render blocks aren't called per sample
+	for (auto& voice : c.Voices())
+		CHECK(voice.calls == 0);
+}
+
+/**
+ * LaneVoiceBank renders the same as a VoiceBank of wavetable voices with the same envelope.
+ */
+void TestLanes()
+{
+	VoiceBank<BlockVoice> bank(8);
+	LaneVoiceBank lanes(8);
+	lanes.Lanes().envelope.s = 0.5;
+	lanes.Lanes().envelope.RecalculateParameters();
+
+	auto generate = [](auto& bank, float* out, int n) { bank.Generate(out, n); };
+	auto expected = Play(bank, generate);
+	auto rendered = Play(lanes, generate);
+	for (int i = 0; i < Frames; i++)
+		CHECK_NEAR(rendered[i], expected[i], 1e-5);
+
+	// Voices that ended are skipped, a new note still plays
+	lanes.NotePress(72);
+	float out[Block];
+	lanes.Generate(out, Block);
+	CHECK(out[Block - 1] != 0);
+}
+
+int main()
+{
+	TestBlockGenerate();
+	TestLanes();
+	return TestResult();
+}
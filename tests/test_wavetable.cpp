@@ -0,0 +1,95 @@
+#include "Test.hpp"
+#include "Oscillator.hpp"
+#include <vector>
+
+using namespace SoundMixr;
+
+constexpr double SampleRate = 48000;
+constexpr int Size = 16384; // 4 times the table, so the phase has a fraction
+
+/**
+ * Fraction of the energy of a signal that isn't at a harmonic of bin. The frequency
+ * is an exact bin, so harmonics land on multiples of it and anything that folded
+ * back from above Nyquist lands in between.
+ */
+template<typename Fun>
+double Aliasing(int bin, Fun generate)
+{
+	std::vector<float> x(Size);
+	for (auto& v : x)
+		v = generate();
+
+	RealFFT fft(Size);
+	std::vector<RealFFT::Complex> bins(Size / 2 + 1);
+	fft.Forward(x.data(), bins.data());
+
+	double harmonic = 0, other = 0;
+	for (int k = 1; k <= Size / 2; k++)
+		(k % bin == 0 ? harmonic : other) += std::norm(bins[k]);
+	return other / (harmonic + other);
+}
+
+/**
+ * High notes only contain harmonics below Nyquist, what's left is the error of the
+ * linear interpolation. The naive Oscillator is the reference that does alias.
+ */
+void TestNoAliasing()
+{
+	// Notes around 2, 4.7 and 10.5 kHz, odd bins so they aren't a whole table step
+	for (int bin : { 683, 1603, 3589 })
+	{
+		const double frequency = bin * SampleRate / Size;
+		WavetableOscillator wavetable{ BandLimitedWavetable::Saw() };
+		wavetable.Frequency(frequency);
+		Oscillator naive;
+		naive.wavetable = Wavetables::Saw, naive.frequency = frequency;
+
+		CHECK(Aliasing(bin, [&] { return wavetable.Process(); }) < 1e-6);
+		CHECK(Aliasing(bin, [&] { return naive.Process(); }) > 1e-3);
+	}
+}
+
+/**
+ * Levels switch one at a time at every octave of the phase increment, and the output
+ * stays continuous when the frequency sweeps across a switch.
+ */
+void TestLevels()
+{
+	int previous = 0;
+	for (uint32_t increment = 1u << 16; increment < (1u << 31); increment += increment >> 6)
+	{
+		int level = BandLimitedWavetable::LevelFor(increment);
+		CHECK(level == previous || level == previous + 1);
+		previous = level;
+	}
+	CHECK(previous == BandLimitedWavetable::Levels - 1);
+
+	// Level k has half the harmonics of level k - 1, so it's used from twice the increment
+	for (int k = 1; k < BandLimitedWavetable::Levels; k++)
+	{
+		uint32_t boundary = 1u << (33 - BandLimitedWavetable::Bits + k - 1);
+		CHECK(BandLimitedWavetable::LevelFor(boundary) == k - 1);
+		CHECK(BandLimitedWavetable::LevelFor(boundary + 1) == k);
+	}
+
+	// Sweep a saw up 6 octaves, no step is larger than its own discontinuity
+	WavetableOscillator osc{ BandLimitedWavetable::Saw() };
+	float previousSample = 0, largest = 0;
+	for (int i = 0; i < 48000; i++)
+	{
+		if (i % 64 == 0)
+			osc.Frequency(100 * std::pow(2.0, 6.0 * i / 48000));
+		float sample = osc.Process();
+		if (i > 0)
+			largest = std::max(largest, std::abs(sample - previousSample));
+		previousSample = sample;
+	}
+	CHECK(largest < 2.5f);
+}
+
+int main()
+{
+	TestNoAliasing();
+	TestLevels();
+	return TestResult();
+}